@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "binstream.h"
+
+// stream setup; a larger pipe buffer means fewer context switches between
+// the two ends of a 'gennum -b | verbank -b' pipeline
+int bin_stream_open(bin_stream* t_stream, int t_fd, size_t t_capacity) {
+    memset(t_stream, 0, sizeof(*t_stream));
+    t_stream->fd = t_fd;
+    t_stream->capacity = t_capacity ? t_capacity : BIN_STREAM_CAPACITY;
+
+    void* l_buf = nullptr;
+    if (posix_memalign(&l_buf, BIN_STREAM_ALIGN, t_stream->capacity) != 0) {
+        fprintf(stderr, "error: cannot allocate %zu bytes stream buffer\n", t_stream->capacity);
+        return -1;
+    }
+    t_stream->buf = (char*)l_buf;
+
+#ifdef F_SETPIPE_SZ
+    struct stat l_stat;
+    if (fstat(t_fd, &l_stat) == 0 && S_ISFIFO(l_stat.st_mode))
+        fcntl(t_fd, F_SETPIPE_SZ, (int)t_stream->capacity); // best effort; capped by /proc/sys/fs/pipe-max-size
+#endif
+
+    return 0;
+}
+
+void bin_stream_close(bin_stream* t_stream) {
+    if (t_stream->pos && !t_stream->len)
+        bin_flush(t_stream); // pending output of a write stream (a read stream has pos <= len)
+
+    free(t_stream->buf);
+    t_stream->buf = nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// read side
+
+// make at least t_min bytes available unless the input ends first
+static size_t bin_fill(bin_stream* t_stream, size_t t_min) {
+    size_t l_avail = t_stream->len - t_stream->pos;
+    if (l_avail >= t_min)
+        return l_avail;
+
+    // move the partial data to the front and refill the rest of the buffer
+    memmove(t_stream->buf, t_stream->buf + t_stream->pos, l_avail);
+    t_stream->pos = 0;
+    t_stream->len = l_avail;
+
+    while (!t_stream->eof && t_stream->len < t_min) {
+        ssize_t l_len = read(t_stream->fd, t_stream->buf + t_stream->len, t_stream->capacity - t_stream->len);
+        if (l_len < 0 && errno == EINTR)
+            continue;
+
+        if (l_len < 0)
+            t_stream->error = errno;
+        if (l_len <= 0) {
+            t_stream->eof = 1;
+            break;
+        }
+
+        t_stream->len += l_len;
+    }
+
+    return t_stream->len;
+}
+
+size_t bin_read_records(bin_stream* t_stream, size_t t_record_size, size_t t_max, const void** t_view) {
+    size_t l_avail = bin_fill(t_stream, t_record_size);
+    if (l_avail < t_record_size)
+        return 0; // end of input; a trailing partial record is dropped
+
+    size_t l_count = l_avail / t_record_size;
+    if (l_count > t_max)
+        l_count = t_max;
+
+    *t_view = t_stream->buf + t_stream->pos;
+    t_stream->pos += l_count * t_record_size;
+
+    return l_count;
+}
+
+size_t bin_peek(bin_stream* t_stream, size_t t_min, const void** t_view) {
+    if (t_min > t_stream->capacity)
+        t_min = t_stream->capacity;
+
+    size_t l_avail = bin_fill(t_stream, t_min);
+    *t_view = t_stream->buf + t_stream->pos;
+
+    return l_avail;
+}
+
+void bin_skip(bin_stream* t_stream, size_t t_size) {
+    t_stream->pos += t_size;
+}
+
+// ----------------------------------------------------------------------------
+// write side
+
+// unbuffered write of a whole block; retries short writes
+int bin_write_all(int t_fd, const void* t_data, size_t t_size) {
+    const char* l_data = (const char*)t_data;
+    size_t l_done = 0;
+
+    while (l_done < t_size) {
+        ssize_t l_len = write(t_fd, l_data + l_done, t_size - l_done);
+        if (l_len < 0 && errno == EINTR)
+            continue;
+
+        if (l_len <= 0)
+            return -1;
+
+        l_done += l_len;
+    }
+
+    return 0;
+}
+
+int bin_flush(bin_stream* t_stream) {
+    if (bin_write_all(t_stream->fd, t_stream->buf, t_stream->pos) != 0)
+        t_stream->error = errno ? errno : EIO;
+
+    t_stream->pos = 0;
+
+    return t_stream->error ? -1 : 0;
+}
+
+int bin_write_slow(bin_stream* t_stream, const void* t_data, size_t t_size) {
+    const char* l_data = (const char*)t_data;
+
+    while (t_size > 0) {
+        if (t_stream->pos == t_stream->capacity && bin_flush(t_stream) != 0)
+            return -1;
+
+        size_t l_chunk = t_stream->capacity - t_stream->pos;
+        if (l_chunk > t_size)
+            l_chunk = t_size;
+
+        memcpy(t_stream->buf + t_stream->pos, l_data, l_chunk);
+        t_stream->pos += l_chunk;
+        l_data += l_chunk;
+        t_size -= l_chunk;
+    }
+
+    return 0;
+}
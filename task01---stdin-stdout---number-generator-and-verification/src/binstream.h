@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+#define BIN_STREAM_CAPACITY (1 << 20) // default buffer size; 1 MiB
+#define BIN_STREAM_ALIGN    4096      // buffers are page aligned
+
+// block-buffered binary stream over a file descriptor
+struct bin_stream {
+    int    fd;
+    char*  buf;
+    size_t capacity;
+    size_t pos; // read: first unconsumed byte; write: bytes buffered
+    size_t len; // read: bytes valid in buffer
+    int    eof;
+    int    error;
+};
+
+// open/close; close flushes a write stream
+int  bin_stream_open(bin_stream* t_stream, int t_fd, size_t t_capacity);
+void bin_stream_close(bin_stream* t_stream);
+
+// read a view of up to t_max whole records of t_record_size bytes; the view
+// stays valid until the next call, short reads are retried until the buffer
+// holds at least one whole record; returns 0 at end of input
+size_t bin_read_records(bin_stream* t_stream, size_t t_record_size, size_t t_max, const void** t_view);
+
+// view of the buffered input without consuming it; reads until at least
+// t_min bytes (at most the capacity) are buffered or the input ends; returns
+// the bytes available. bin_skip() consumes them
+size_t bin_peek(bin_stream* t_stream, size_t t_min, const void** t_view);
+void   bin_skip(bin_stream* t_stream, size_t t_size);
+
+// write; returns 0 on success, -1 on a write error
+int bin_write_all(int t_fd, const void* t_data, size_t t_size);
+int bin_flush(bin_stream* t_stream);
+int bin_write_slow(bin_stream* t_stream, const void* t_data, size_t t_size);
+
+static inline int bin_write(bin_stream* t_stream, const void* t_data, size_t t_size) {
+    if (t_stream->pos + t_size > t_stream->capacity)
+        return bin_write_slow(t_stream, t_data, t_size);
+
+    memcpy(t_stream->buf + t_stream->pos, t_data, t_size);
+    t_stream->pos += t_size;
+
+    return 0;
+}
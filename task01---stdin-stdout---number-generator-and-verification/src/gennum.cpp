@@ -2,37 +2,85 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <limits.h>
 
 #include "gennumcore.h"
 
+static void usage(const char* t_name) {
+    fprintf(stderr, "usage: %s [-b|-z] [-o file [-j n]] s [n]\n", t_name);
+    fprintf(stderr, "       %s [-b] --random seed [n] [--valid-ratio r] [--valid account|pid]\n", t_name);
+    fprintf(stderr, "-b  binary output mode\n");
+    fprintf(stderr, "-z  framed binary output mode (delta+varint; for verbank -z)\n");
+    fprintf(stderr, "-o  write into a preallocated file instead of stdout (text or -b)\n");
+    fprintf(stderr, "-j  number of threads writing the -o file in parallel (default: 1)\n");
+    fprintf(stderr, "s   starting number (long)\n");
+    fprintf(stderr, "n   count of numbers (long, default: 1000)\n");
+    fprintf(stderr, "--random       n random numbers of 0..9999999999 instead of a range\n");
+    fprintf(stderr, "--valid-ratio  fraction 0..1 of them replaced by valid numbers\n");
+    fprintf(stderr, "--valid        kind of the valid numbers (default: account)\n");
+}
+
 int main(int t_argc, char** t_argv) {
     int binary_mode = 0;
-    int arg_start = 1;  // index where S argument starts
+    int framed_mode = 0;
+    const char* output_file = nullptr;
+    int threads = 1;
+    int threads_given = 0;
+
+    int random_mode = 0;
+    unsigned long random_seed = 0;
+    double valid_ratio = 0;
+    int valid_kind = RANDOM_VALID_ACCOUNT;
+
+    // flags anywhere; everything else is positional. a negative S ("-5") is
+    // not a flag, so it is positional as well
+    const char* args[2];
+    int arg_count = 0;
+    for (int i = 1; i < t_argc; i++) {
+        if (strcmp(t_argv[i], "-b") == 0)
+            binary_mode = 1;
+        else if (strcmp(t_argv[i], "-z") == 0)
+            framed_mode = 1;
+        else if (strcmp(t_argv[i], "-o") == 0 && i + 1 < t_argc)
+            output_file = t_argv[++i];
+        else if (strcmp(t_argv[i], "-j") == 0 && i + 1 < t_argc) {
+            threads = atoi(t_argv[++i]);
+            threads_given = 1;
+        } else if (strcmp(t_argv[i], "--random") == 0 && i + 1 < t_argc) {
+            random_mode = 1;
+            random_seed = strtoul(t_argv[++i], nullptr, 0);
+        } else if (strcmp(t_argv[i], "--valid-ratio") == 0 && i + 1 < t_argc)
+            valid_ratio = atof(t_argv[++i]);
+        else if (strcmp(t_argv[i], "--valid") == 0 && i + 1 < t_argc && strcmp(t_argv[i + 1], "account") == 0) {
+            valid_kind = RANDOM_VALID_ACCOUNT;
+            i++;
+        } else if (strcmp(t_argv[i], "--valid") == 0 && i + 1 < t_argc && strcmp(t_argv[i + 1], "pid") == 0) {
+            valid_kind = RANDOM_VALID_PID;
+            i++;
+        } else if (arg_count < 2 && (t_argv[i][0] != '-' || (t_argv[i][1] >= '0' && t_argv[i][1] <= '9')))
+            args[arg_count++] = t_argv[i];
+        else {
+            usage(t_argv[0]);
 
-    // check for -b flag
-    if (t_argc > 1 && strcmp(t_argv[1], "-b") == 0) {
-        binary_mode = 1;
-        arg_start = 2;
+            return 1;
+        }
     }
 
-    // check number of arguments (accounting for possible -b flag)
-    int remaining_args = t_argc - arg_start;
-    if (remaining_args < 1 || remaining_args > 2) {
-        fprintf(stderr, "usage: %s [-b] s [n]\n", t_argv[0]);
-        fprintf(stderr, "-b  binary output mode\n");
-        fprintf(stderr, "s   starting number (long)\n");
-        fprintf(stderr, "n   count of numbers (default: 1000)\n");
+    // check number of arguments; --random takes only n
+    int min_args = random_mode ? 0 : 1;
+    if (arg_count < min_args || arg_count > min_args + 1 || (binary_mode && framed_mode)) {
+        usage(t_argv[0]);
 
         return 1;
     }
 
     // read starting number from command line; long by assignment
-    long start_num = atol(t_argv[arg_start]);
+    long start_num = random_mode ? 0 : atol(args[0]);
 
     // read the count of numbers N (default: 1000)
-    int count = 1000;
-    if (remaining_args == 2)
-        count = atoi(t_argv[arg_start + 1]);
+    long count = 1000;
+    if (arg_count == min_args + 1)
+        count = atol(args[min_args]);
 
     if (count <= 0) {
         fprintf(stderr, "error: count must be positive\n");
@@ -40,9 +88,57 @@ int main(int t_argc, char** t_argv) {
         return 1;
     }
 
+    if (start_num > LONG_MAX - (count - 1)) {
+        fprintf(stderr, "error: s + n - 1 exceeds the long range\n");
+
+        return 1;
+    }
+
+    if (threads_given && !output_file) {
+        fprintf(stderr, "error: -j needs -o, stdout is written by one thread\n");
+
+        return 1;
+    }
+
+    if (threads < 1) {
+        fprintf(stderr, "error: thread count must be positive\n");
+
+        return 1;
+    }
+
+    if (random_mode) {
+        if (framed_mode || output_file) {
+            fprintf(stderr, "error: --random writes text or -b output to stdout only\n");
+
+            return 1;
+        }
+        if (valid_ratio < 0 || valid_ratio > 1) {
+            fprintf(stderr, "error: valid ratio must be between 0 and 1\n");
+
+            return 1;
+        }
+
+        generate_numbers_random(random_seed, count, valid_ratio, valid_kind, binary_mode);
+
+        return 0;
+    }
+
+    // generate into a file
+    if (output_file) {
+        if (framed_mode) {
+            fprintf(stderr, "error: -o supports text and -b output only\n");
+
+            return 1;
+        }
+
+        return generate_numbers_file(output_file, start_num, count, binary_mode, threads);
+    }
+
     // generate and print numbers
     if (binary_mode)
         generate_numbers_binary(start_num, count);
+    else if (framed_mode)
+        generate_numbers_framed(start_num, count);
     else
         generate_numbers(start_num, count);
 
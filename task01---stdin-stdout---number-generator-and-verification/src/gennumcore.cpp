@@ -1,18 +1,290 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "gennumcore.h"
+#include "binstream.h"
+#include "numcodec.h"
+#include "numframe.h"
+#include "numrandom.h"
+
+// ----------------------------------------------------------------------------
+// record writers shared by the stdout and the file modes
+
+static void write_text_records(bin_stream* t_out, long t_start, long t_count) {
+    char line[NUM_TEXT_MAX + 1];
+    for (long i = 0; i < t_count; i++) {
+        size_t len = format_number(t_start + i, line);
+        line[len++] = '\n';
+
+        if (bin_write(t_out, line, len) != 0)
+            break; // broken pipe etc.
+    }
+}
+
+static void write_binary_records(bin_stream* t_out, long t_start, long t_count) {
+    for (long i = 0; i < t_count; i++) {
+        long number = t_start + i;
+        if (bin_write(t_out, &number, sizeof(long)) != 0)
+            break; // broken pipe etc.
+    }
+}
+
+// ----------------------------------------------------------------------------
+// stdout
 
 // number generator - text mode
-void generate_numbers(long t_start, int t_count) {
-    for (int i = 0; i < t_count; i++)
-        printf("%010ld\n", t_start + i);
+void generate_numbers(long t_start, long t_count) {
+    bin_stream out;
+    if (bin_stream_open(&out, STDOUT_FILENO, 0) != 0)
+        return;
+
+    write_text_records(&out, t_start, t_count);
+
+    bin_stream_close(&out);
 }
 
 // number generator - binary mode
-void generate_numbers_binary(long t_start, int t_count) {
-    for (int i = 0; i < t_count; i++) {
-        long number = t_start + i;
-        write(STDOUT_FILENO, &number, sizeof(long));
+void generate_numbers_binary(long t_start, long t_count) {
+    bin_stream out;
+    if (bin_stream_open(&out, STDOUT_FILENO, 0) != 0)
+        return;
+
+    write_binary_records(&out, t_start, t_count);
+
+    bin_stream_close(&out);
+}
+
+// number generator - framed (delta+varint) binary mode
+void generate_numbers_framed(long t_start, long t_count) {
+    bin_stream out;
+    if (bin_stream_open(&out, STDOUT_FILENO, 0) != 0)
+        return;
+
+    static long numbers[FRAME_NUMBERS];
+    static char frame[FRAME_MAX_BYTES];
+
+    frame_header(0, frame);
+    bin_write(&out, frame, FRAME_HEADER);
+
+    for (long i = 0; i < t_count; ) {
+        int count = 0;
+        for (; count < FRAME_NUMBERS && i < t_count; count++, i++)
+            numbers[count] = t_start + i;
+
+        size_t len = frame_encode(numbers, nullptr, count, frame);
+        if (bin_write(&out, frame, len) != 0)
+            break; // broken pipe etc.
+    }
+
+    bin_stream_close(&out);
+}
+
+// ----------------------------------------------------------------------------
+// random workload
+
+#define RANDOM_BLOCK 4096 // numbers per PRNG block; multiple of RNG_LANES
+
+void generate_numbers_random(uint64_t t_seed, long t_count, double t_valid_ratio, int t_valid_kind, int t_binary) {
+    bin_stream out;
+    if (bin_stream_open(&out, STDOUT_FILENO, 0) != 0)
+        return;
+
+    static rng_lanes rng;
+    rng_seed(&rng, t_seed);
+
+    // a number is replaced by a valid one if its second random word is below this
+    uint64_t l_threshold = t_valid_ratio <= 0 ? 0
+                         : t_valid_ratio >= 1 ? UINT64_MAX
+                         : (uint64_t)(t_valid_ratio * 18446744073709551616.0);
+
+    static uint64_t randoms[2 * RANDOM_BLOCK];
+    static long numbers[RANDOM_BLOCK];
+    char line[NUM_TEXT_MAX + 1];
+
+    for (long done = 0; done < t_count && !out.error; done += RANDOM_BLOCK) {
+        long count = t_count - done < RANDOM_BLOCK ? t_count - done : RANDOM_BLOCK;
+        rng_fill(&rng, randoms, 2 * RANDOM_BLOCK);
+
+        // uniform in 0..9999999999, the range of the fixed text format
+        for (long i = 0; i < count; i++)
+            numbers[i] = (long)(((unsigned __int128)randoms[i] * 10000000000ULL) >> 64);
+
+        if (l_threshold)
+            for (long i = 0; i < count; i++)
+                if (randoms[RANDOM_BLOCK + i] < l_threshold || l_threshold == UINT64_MAX)
+                    numbers[i] = t_valid_kind == RANDOM_VALID_PID ? make_valid_pid(randoms[i])
+                                                                   : make_valid_account(randoms[i]);
+
+        if (t_binary) {
+            bin_write(&out, numbers, count * sizeof(long));
+            continue;
+        }
+
+        for (long i = 0; i < count; i++) {
+            size_t len = format_number(numbers[i], line);
+            line[len++] = '\n';
+
+            if (bin_write(&out, line, len) != 0)
+                break; // broken pipe etc.
+        }
+    }
+
+    bin_stream_close(&out);
+}
+
+// ----------------------------------------------------------------------------
+// file; every thread writes a disjoint region of the preallocated file
+
+// bytes of the "%010ld\n" lines of all |x| in [t_low, t_high); t_sign is 1
+// for negative numbers, whose sign takes one of the ten padded places
+static unsigned long text_bytes_unsigned(unsigned long t_low, unsigned long t_high, int t_sign) {
+    unsigned long l_total = 0;
+    unsigned long l_band_end = 10; // numbers below have l_digits digits
+
+    for (int l_digits = 1; t_low < t_high; l_digits++) {
+        if (t_low < l_band_end) {
+            unsigned long l_end = t_high < l_band_end ? t_high : l_band_end;
+            int l_width = l_digits + t_sign > 10 ? l_digits + t_sign : 10;
+            l_total += (l_end - t_low) * (l_width + 1); // padded number and '\n'
+            t_low = l_end;
+        }
+
+        l_band_end = l_digits < 19 ? l_band_end * 10 : (unsigned long)-1;
+    }
+
+    return l_total;
+}
+
+unsigned long text_length(long t_start, long t_count) {
+    if (t_count <= 0)
+        return 0;
+
+    long l_last = t_start + (t_count - 1);
+    unsigned long l_total = 0;
+
+    if (t_start < 0) {
+        long l_neg_last = l_last < 0 ? l_last : -1;
+        l_total += text_bytes_unsigned(-(unsigned long)l_neg_last, -(unsigned long)t_start + 1, 1);
+    }
+
+    if (l_last >= 0)
+        l_total += text_bytes_unsigned(t_start > 0 ? t_start : 0, (unsigned long)l_last + 1, 0);
+
+    return l_total;
+}
+
+struct file_part {
+    const char* path;
+    int         binary_mode;
+    long        start;
+    long        count;
+    off_t       offset;
+    int         error;
+};
+
+static void* file_part_thread(void* t_arg) {
+    file_part* l_part = (file_part*)t_arg;
+
+    // own descriptor, so the file position is private to the thread
+    int l_fd = open(l_part->path, O_WRONLY);
+    if (l_fd < 0 || lseek(l_fd, l_part->offset, SEEK_SET) < 0) {
+        l_part->error = errno;
+        if (l_fd >= 0)
+            close(l_fd);
+        return nullptr;
+    }
+
+    bin_stream out;
+    if (bin_stream_open(&out, l_fd, 0) != 0) {
+        l_part->error = ENOMEM;
+        close(l_fd);
+        return nullptr;
+    }
+
+    if (l_part->binary_mode)
+        write_binary_records(&out, l_part->start, l_part->count);
+    else
+        write_text_records(&out, l_part->start, l_part->count);
+
+    bin_stream_close(&out);
+    l_part->error = out.error;
+    if (close(l_fd) != 0 && !l_part->error)
+        l_part->error = errno;
+
+    return nullptr;
+}
+
+int generate_numbers_file(const char* t_path, long t_start, long t_count, int t_binary, int t_threads) {
+    if (t_threads < 1)
+        t_threads = 1;
+    if (t_threads > t_count)
+        t_threads = (int)t_count;
+
+    int l_fd = open(t_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (l_fd < 0) {
+        perror(t_path);
+        return 1;
+    }
+
+    // reserve the whole file up front; filesystems without fallocate get a sparse file
+    off_t l_size = t_binary ? (off_t)t_count * (off_t)sizeof(long) : (off_t)text_length(t_start, t_count);
+    int l_error = posix_fallocate(l_fd, 0, l_size);
+    if (l_error == EOPNOTSUPP || l_error == EINVAL)
+        l_error = ftruncate(l_fd, l_size) != 0 ? errno : 0;
+    close(l_fd);
+
+    if (l_error) {
+        fprintf(stderr, "error: %s: cannot allocate %ld bytes: %s\n", t_path, (long)l_size, strerror(l_error));
+        return 1;
+    }
+
+    file_part* l_parts = (file_part*)calloc(t_threads, sizeof(file_part));
+    pthread_t* l_tids = (pthread_t*)calloc(t_threads, sizeof(pthread_t));
+    if (!l_parts || !l_tids) {
+        fprintf(stderr, "error: out of memory\n");
+        free(l_parts);
+        free(l_tids);
+        return 1;
     }
-}
\ No newline at end of file
+
+    long l_done = 0;
+    for (int i = 0; i < t_threads; i++) {
+        file_part* l_part = &l_parts[i];
+        l_part->path = t_path;
+        l_part->binary_mode = t_binary;
+        l_part->start = t_start + l_done;
+        l_part->count = t_count / t_threads + (i < t_count % t_threads);
+        l_part->offset = t_binary ? (off_t)l_done * (off_t)sizeof(long) : (off_t)text_length(t_start, l_done);
+        l_done += l_part->count;
+    }
+
+    int l_started = 0;
+    for (; l_started < t_threads; l_started++)
+        if (pthread_create(&l_tids[l_started], nullptr, file_part_thread, &l_parts[l_started]) != 0)
+            break;
+
+    // not enough threads; the rest is written here
+    for (int i = l_started; i < t_threads; i++)
+        file_part_thread(&l_parts[i]);
+
+    int l_result = 0;
+    for (int i = 0; i < t_threads; i++) {
+        if (i < l_started)
+            pthread_join(l_tids[i], nullptr);
+
+        if (l_parts[i].error && !l_result) {
+            fprintf(stderr, "error: %s: %s\n", t_path, strerror(l_parts[i].error));
+            l_result = 1;
+        }
+    }
+
+    free(l_parts);
+    free(l_tids);
+
+    return l_result;
+}
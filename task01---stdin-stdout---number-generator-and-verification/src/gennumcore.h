@@ -1,2 +1,21 @@
-void generate_numbers(long t_start, int t_count);
-void generate_numbers_binary(long t_start, int t_count);
+#include <stdint.h>
+
+void generate_numbers(long t_start, long t_count);
+void generate_numbers_binary(long t_start, long t_count);
+void generate_numbers_framed(long t_start, long t_count);
+
+// kind of injected valid numbers
+#define RANDOM_VALID_ACCOUNT 0 // CNB checksum (vercore_account)
+#define RANDOM_VALID_PID     1 // 10-digit PID (vercore_pid)
+
+// t_count random numbers of 0..9999999999 (text or binary); a fraction
+// t_valid_ratio of them is replaced by valid ones of t_valid_kind
+// (RANDOM_VALID_ACCOUNT or RANDOM_VALID_PID); the same seed gives the same output
+void generate_numbers_random(uint64_t t_seed, long t_count, double t_valid_ratio, int t_valid_kind, int t_binary);
+
+// bytes of the text output of t_count numbers from t_start
+unsigned long text_length(long t_start, long t_count);
+
+// text or binary records into a file, t_threads threads writing disjoint
+// regions in parallel; returns 0 on success
+int generate_numbers_file(const char* t_path, long t_start, long t_count, int t_binary, int t_threads);
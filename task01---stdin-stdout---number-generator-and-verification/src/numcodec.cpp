@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "numcodec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define NUMCODEC_SSE2 1
+#endif
+
+// ----------------------------------------------------------------------------
+// formatting
+
+// "00" "01" ... "99"
+struct digit_pairs {
+    char pair[200];
+
+    constexpr digit_pairs() : pair() {
+        for (int i = 0; i < 100; i++) {
+            pair[2 * i]     = (char)('0' + i / 10);
+            pair[2 * i + 1] = (char)('0' + i % 10);
+        }
+    }
+};
+
+static constexpr digit_pairs g_digit_pairs;
+
+static inline void put_pair(char* t_out, unsigned t_value) {
+    memcpy(t_out, &g_digit_pairs.pair[2 * t_value], 2);
+}
+
+size_t format_number(long t_number, char* t_out) {
+    if (t_number < 0 || t_number > 9999999999L) {
+        // negative or wider than the fixed format; rare enough for snprintf
+        char l_buf[NUM_TEXT_MAX + 1];
+        int l_len = snprintf(l_buf, sizeof(l_buf), "%010ld", t_number);
+        memcpy(t_out, l_buf, l_len);
+
+        return l_len;
+    }
+
+    // 10 digits as 2 + 8; the 8-digit part as four pairs
+    unsigned l_hi = (unsigned)(t_number / 100000000);
+    unsigned l_lo = (unsigned)(t_number % 100000000);
+    unsigned l_lo_hi = l_lo / 10000;
+    unsigned l_lo_lo = l_lo % 10000;
+
+    put_pair(t_out,     l_hi);
+    put_pair(t_out + 2, l_lo_hi / 100);
+    put_pair(t_out + 4, l_lo_hi % 100);
+    put_pair(t_out + 6, l_lo_lo / 100);
+    put_pair(t_out + 8, l_lo_lo % 100);
+
+    return 10;
+}
+
+// ----------------------------------------------------------------------------
+// parsing
+
+// 8 ASCII digits to their value without a loop (SWAR)
+static inline uint64_t parse_eight_digits(const char* t_text) {
+    uint64_t l_val;
+    memcpy(&l_val, t_text, 8);
+
+    l_val -= 0x3030303030303030ULL;
+    l_val = (l_val * 10) + (l_val >> 8); // pairs
+    l_val = (((l_val & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+           + (((l_val >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+
+    return l_val;
+}
+
+// count of leading ASCII digits in the 16 bytes at t_text
+static inline int leading_digits(const char* t_text) {
+#ifdef NUMCODEC_SSE2
+    __m128i l_chunk = _mm_loadu_si128((const __m128i*)t_text);
+    __m128i l_ge0 = _mm_cmpeq_epi8(_mm_max_epu8(l_chunk, _mm_set1_epi8('0')), l_chunk);
+    __m128i l_le9 = _mm_cmpeq_epi8(_mm_min_epu8(l_chunk, _mm_set1_epi8('9')), l_chunk);
+    unsigned l_mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(l_ge0, l_le9));
+
+    return __builtin_ctz(~l_mask); // bit 16 is always clear in ~mask
+#else
+    int l_count = 0;
+    while (l_count < 16 && t_text[l_count] >= '0' && t_text[l_count] <= '9')
+        l_count++;
+
+    return l_count;
+#endif
+}
+
+size_t parse_numbers(const char* t_text, size_t t_len, long* t_numbers, int* t_stop) {
+    const char* l_ptr = t_text;
+    const char* l_end = t_text + t_len;
+    size_t l_count = 0;
+
+    *t_stop = 0;
+    while (true) {
+        while (l_ptr < l_end && isspace((unsigned char)*l_ptr))
+            l_ptr++;
+        if (l_ptr == l_end)
+            break;
+
+        // fast path - plain digits followed by whitespace or the end of text
+        int l_digits = leading_digits(l_ptr);
+        if (l_digits > 0 && l_digits <= 16 && (l_ptr + l_digits == l_end || isspace((unsigned char)l_ptr[l_digits]))) {
+            uint64_t l_val = 0;
+            int i = 0;
+            if (l_digits >= 8) {
+                l_val = parse_eight_digits(l_ptr);
+                i = 8;
+            }
+            for (; i < l_digits; i++)
+                l_val = l_val * 10 + (l_ptr[i] - '0');
+
+            t_numbers[l_count++] = (long)l_val;
+            l_ptr += l_digits;
+            continue;
+        }
+
+        // signs, long tokens and trailing garbage follow strtol()
+        char* l_next;
+        long l_number = strtol(l_ptr, &l_next, 10);
+        if (l_next == l_ptr) {
+            *t_stop = 1;
+            break;
+        }
+
+        t_numbers[l_count++] = l_number;
+        l_ptr = l_next;
+    }
+
+    return l_count;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+
+// text codec for the pipeline's 10-digit zero-padded format ("%010ld")
+
+#define NUM_TEXT_MAX      24 // longest formatted number incl. sign
+#define NUM_PARSE_PADDING 16 // readable bytes required past the end of parsed text
+
+// write exactly what printf("%010ld") would, without the NUL; returns the
+// length. numbers in 0..9999999999 take the table driven fast path
+size_t format_number(long t_number, char* t_out);
+
+// parse whitespace separated numbers the way repeated scanf("%ld") calls do,
+// up to the first token that is not a number (*t_stop is then set); t_text
+// must be NUL terminated at t_len and readable NUM_PARSE_PADDING bytes past
+// it. t_numbers needs room for t_len / 2 + 1 numbers; returns the count
+size_t parse_numbers(const char* t_text, size_t t_len, long* t_numbers, int* t_stop);
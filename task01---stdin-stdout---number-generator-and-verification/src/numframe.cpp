@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "numframe.h"
+
+// ----------------------------------------------------------------------------
+// varint (LEB128) with zigzag mapping of signed values
+
+static inline size_t put_varint(uint64_t t_value, char* t_out) {
+    size_t l_len = 0;
+    while (t_value >= 0x80) {
+        t_out[l_len++] = (char)(t_value | 0x80);
+        t_value >>= 7;
+    }
+    t_out[l_len++] = (char)t_value;
+
+    return l_len;
+}
+
+// returns bytes used, 0 if the varint is truncated or too long
+static inline size_t get_varint(const uint8_t* t_in, size_t t_avail, uint64_t* t_value) {
+    uint64_t l_value = 0;
+    for (size_t i = 0; i < t_avail && i < 10; i++) {
+        l_value |= (uint64_t)(t_in[i] & 0x7f) << (7 * i);
+        if (!(t_in[i] & 0x80)) {
+            *t_value = l_value;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+static inline uint64_t zigzag(long t_value) {
+    return ((uint64_t)t_value << 1) ^ (uint64_t)(t_value >> 63);
+}
+
+static inline long unzigzag(uint64_t t_value) {
+    return (long)(t_value >> 1) ^ -(long)(t_value & 1);
+}
+
+// ----------------------------------------------------------------------------
+// encoding
+
+void frame_header(uint8_t t_flags, char* t_out) {
+    memcpy(t_out, FRAME_MAGIC, 4);
+    t_out[4] = FRAME_VERSION;
+    t_out[5] = (char)t_flags;
+    t_out[6] = 0;
+    t_out[7] = 0;
+}
+
+size_t frame_encode(const long* t_numbers, const uint8_t* t_valid, size_t t_count, char* t_out) {
+    size_t l_len = put_varint(t_count, t_out);
+    if (t_count == 0)
+        return l_len;
+
+    l_len += put_varint(zigzag(t_numbers[0]), t_out + l_len);
+    for (size_t i = 1; i < t_count; i++)
+        l_len += put_varint(zigzag((long)((uint64_t)t_numbers[i] - (uint64_t)t_numbers[i - 1])), t_out + l_len);
+
+    if (t_valid) {
+        size_t l_bytes = (t_count + 7) / 8;
+        memset(t_out + l_len, 0, l_bytes);
+        for (size_t i = 0; i < t_count; i++)
+            if (t_valid[i])
+                t_out[l_len + i / 8] |= (char)(1 << (i % 8));
+        l_len += l_bytes;
+    }
+
+    return l_len;
+}
+
+// ----------------------------------------------------------------------------
+// decoding
+
+int frame_read_header(bin_stream* t_in) {
+    const void* l_view;
+    if (bin_peek(t_in, FRAME_HEADER, &l_view) < FRAME_HEADER) {
+        fprintf(stderr, "error: framed input too short for a header\n");
+        return -1;
+    }
+
+    const char* l_header = (const char*)l_view;
+    if (memcmp(l_header, FRAME_MAGIC, 4) != 0 || l_header[4] != FRAME_VERSION) {
+        fprintf(stderr, "error: input is not a framed (-z) stream\n");
+        return -1;
+    }
+
+    bin_skip(t_in, FRAME_HEADER);
+
+    return (uint8_t)l_header[5];
+}
+
+static long frame_malformed() {
+    fprintf(stderr, "error: malformed or truncated frame in framed input\n");
+    return -1;
+}
+
+long frame_decode(bin_stream* t_in, int t_flags, long* t_numbers, uint8_t* t_valid) {
+    const void* l_view;
+    size_t l_avail = bin_peek(t_in, FRAME_MAX_BYTES, &l_view);
+    if (l_avail == 0)
+        return 0; // end of input
+
+    const uint8_t* l_in = (const uint8_t*)l_view;
+    uint64_t l_value;
+    size_t l_pos = get_varint(l_in, l_avail, &l_value);
+    if (l_pos == 0 || l_value == 0 || l_value > FRAME_NUMBERS)
+        return frame_malformed();
+
+    size_t l_count = (size_t)l_value;
+    long l_number = 0;
+    for (size_t i = 0; i < l_count; i++) {
+        size_t l_len = get_varint(l_in + l_pos, l_avail - l_pos, &l_value);
+        if (l_len == 0)
+            return frame_malformed();
+        l_pos += l_len;
+
+        // first number absolute, the rest relative to the previous one
+        l_number = i ? (long)((uint64_t)l_number + (uint64_t)unzigzag(l_value)) : unzigzag(l_value);
+        t_numbers[i] = l_number;
+    }
+
+    if (t_flags & FRAME_RESULTS) {
+        size_t l_bytes = (l_count + 7) / 8;
+        if (l_avail - l_pos < l_bytes)
+            return frame_malformed();
+
+        if (t_valid)
+            for (size_t i = 0; i < l_count; i++)
+                t_valid[i] = (l_in[l_pos + i / 8] >> (i % 8)) & 1;
+        l_pos += l_bytes;
+    }
+
+    bin_skip(t_in, l_pos);
+
+    return (long)l_count;
+}
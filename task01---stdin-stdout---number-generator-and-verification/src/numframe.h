@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "binstream.h"
+
+// framed, delta+varint compressed binary stream ('gennum -z', 'verbank -z')
+//
+//   header   "VBZ1", version, flags, 2 reserved bytes
+//   frame    varint count (1..FRAME_NUMBERS)
+//            zigzag varint of the first number
+//            count - 1 zigzag varint deltas to the previous number
+//            [flags & FRAME_RESULTS] (count + 7) / 8 bytes validity bitmap, LSB first
+//
+// frames do not depend on each other, so they can be encoded in parallel
+
+#define FRAME_MAGIC     "VBZ1"
+#define FRAME_VERSION   1
+#define FRAME_HEADER    8
+#define FRAME_NUMBERS   4096 // numbers per frame at most
+#define FRAME_MAX_BYTES (5 + 10 * FRAME_NUMBERS + FRAME_NUMBERS / 8)
+
+#define FRAME_RESULTS   0x01 // frames carry a validity bitmap
+
+// header into t_out (FRAME_HEADER bytes)
+void frame_header(uint8_t t_flags, char* t_out);
+
+// encode up to FRAME_NUMBERS numbers as one frame into t_out (room for
+// FRAME_MAX_BYTES); t_valid is nullptr for a number-only stream; returns the size
+size_t frame_encode(const long* t_numbers, const uint8_t* t_valid, size_t t_count, char* t_out);
+
+// read and check the header; returns the flags or -1
+int frame_read_header(bin_stream* t_in);
+
+// decode the next frame into t_numbers (and t_valid if the stream carries
+// results and t_valid is not nullptr); returns the count, 0 at the end of
+// input and -1 on a malformed frame
+long frame_decode(bin_stream* t_in, int t_flags, long* t_numbers, uint8_t* t_valid);
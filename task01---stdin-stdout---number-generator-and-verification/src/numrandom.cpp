@@ -0,0 +1,117 @@
+#include "numrandom.h"
+
+// ----------------------------------------------------------------------------
+// generator
+
+static inline uint64_t splitmix64(uint64_t* t_state) {
+    uint64_t z = (*t_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+void rng_seed(rng_lanes* t_rng, uint64_t t_seed) {
+    for (int l = 0; l < RNG_LANES; l++) {
+        t_rng->s0[l] = splitmix64(&t_seed);
+        t_rng->s1[l] = splitmix64(&t_seed);
+        t_rng->s2[l] = splitmix64(&t_seed);
+        t_rng->s3[l] = splitmix64(&t_seed);
+    }
+}
+
+static inline uint64_t rotl(uint64_t t_x, int t_k) {
+    return (t_x << t_k) | (t_x >> (64 - t_k));
+}
+
+// the multiplies by 5 and 9 are shifts and adds, so the lanes vectorize even
+// without a 64-bit vector multiply
+__attribute__((optimize("tree-vectorize")))
+void rng_fill(rng_lanes* t_rng, uint64_t* t_out, size_t t_count) {
+    uint64_t s0[RNG_LANES], s1[RNG_LANES], s2[RNG_LANES], s3[RNG_LANES];
+    for (int l = 0; l < RNG_LANES; l++) {
+        s0[l] = t_rng->s0[l];
+        s1[l] = t_rng->s1[l];
+        s2[l] = t_rng->s2[l];
+        s3[l] = t_rng->s3[l];
+    }
+
+    for (size_t j = 0; j < t_count; j += RNG_LANES)
+        for (int l = 0; l < RNG_LANES; l++) {
+            t_out[j + l] = rotl(s1[l] * 5, 7) * 9;
+
+            uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = rotl(s3[l], 45);
+        }
+
+    for (int l = 0; l < RNG_LANES; l++) {
+        t_rng->s0[l] = s0[l];
+        t_rng->s1[l] = s1[l];
+        t_rng->s2[l] = s2[l];
+        t_rng->s3[l] = s3[l];
+    }
+}
+
+// ----------------------------------------------------------------------------
+// valid numbers
+
+// uniform in [0, t_range) from the high bits of a random word
+static inline uint64_t draw(uint64_t* t_random, uint64_t t_range) {
+    uint64_t l_value = (uint64_t)(((unsigned __int128)*t_random * t_range) >> 64);
+    *t_random = *t_random * 0x9e3779b97f4a7c15ULL + 1; // next word for the next draw
+
+    return l_value;
+}
+
+// CNB weighted sums mod 11 of the digit triples 1-3, 4-6 and 7-9
+struct cnb_triple_table {
+    uint8_t sum[3][1000];
+
+    constexpr cnb_triple_table() : sum() {
+        const int weights[10] = { 1, 2, 4, 8, 5, 10, 9, 7, 3, 6 };
+
+        for (int t = 0; t < 3; t++)
+            for (int v = 0; v < 1000; v++)
+                sum[t][v] = (uint8_t)((v % 10 * weights[3 * t + 1] + v / 10 % 10 * weights[3 * t + 2] + v / 100 * weights[3 * t + 3]) % 11);
+    }
+};
+
+static constexpr cnb_triple_table g_cnb_triples;
+
+long make_valid_account(uint64_t t_random) {
+    for (;;) {
+        // digits 9-1 random, digit 0 (weight 1) completes the sum to 0 mod 11
+        unsigned l_high = (unsigned)draw(&t_random, 1000000000ULL);
+        int l_sum = g_cnb_triples.sum[0][l_high % 1000] + g_cnb_triples.sum[1][l_high / 1000 % 1000]
+                  + g_cnb_triples.sum[2][l_high / 1000000];
+
+        int l_digit = (33 - l_sum) % 11; // l_sum <= 30
+        if (l_digit < 10)
+            return (long)l_high * 10 + l_digit;
+        // check digit would be 10; 1 in 11, draw again
+    }
+}
+
+long make_valid_pid(uint64_t t_random) {
+    static const int k_days_in_month[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    static const int k_month_offsets[3] = { 0, 20, 50 };
+
+    for (;;) {
+        // YYMMDDXXX with YY >= 10 so the number has 10 digits; C makes it divisible by 11
+        long l_year = 10 + (long)draw(&t_random, 90);
+        int  l_month = 1 + (int)draw(&t_random, 12);
+        long l_day = 1 + (long)draw(&t_random, k_days_in_month[l_month - 1]);
+        long l_serial = (long)draw(&t_random, 1000);
+        l_month += k_month_offsets[draw(&t_random, 3)];
+
+        long l_base = ((l_year * 100 + l_month) * 100 + l_day) * 1000 + l_serial;
+        int  l_check = (int)((11 - (l_base * 10) % 11) % 11);
+        if (l_check < 10)
+            return l_base * 10 + l_check;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// xoshiro256** over RNG_LANES independent states kept as structure of arrays,
+// so every step of all lanes compiles to vector instructions; a block of
+// output is lane-interleaved
+#define RNG_LANES 8
+
+struct rng_lanes {
+    uint64_t s0[RNG_LANES];
+    uint64_t s1[RNG_LANES];
+    uint64_t s2[RNG_LANES];
+    uint64_t s3[RNG_LANES];
+};
+
+// lanes seeded from one 64-bit seed by splitmix64
+void rng_seed(rng_lanes* t_rng, uint64_t t_seed);
+
+// t_count random words; t_count is a multiple of RNG_LANES
+void rng_fill(rng_lanes* t_rng, uint64_t* t_out, size_t t_count);
+
+// random word -> number of 0..9999999999 passing the chosen check
+long make_valid_account(uint64_t t_random);
+long make_valid_pid(uint64_t t_random);
@@ -0,0 +1,30 @@
+#pragma once
+
+// valid MMDD parts of a PID; digits 2-5 of the zero-padded number, month
+// stored as is (1-12), +20 (special cases, foreigners, etc.) or +50 (women).
+// the year takes no part in the check, so the table of valid YYMMDD prefixes
+// reduces to the 10000 MMDD values; built at compile time
+//
+// shared by vercore_pid and the rule engine (verrules)
+struct pid_date_table {
+    unsigned char valid[10000];
+
+    constexpr pid_date_table() : valid() {
+        // February may have 29 days (leap years are not checked)
+        const int days_in_month[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        const int month_offsets[] = { 0, 20, 50 };
+
+        for (int offset : month_offsets)
+            for (int month = 1; month <= 12; month++)
+                for (int day = 1; day <= days_in_month[month - 1]; day++)
+                    valid[(month + offset) * 100 + day] = 1;
+    }
+};
+
+static constexpr pid_date_table g_pid_dates;
+
+// MMDD of a PID: (id / 10^4) mod 10^4; constant divisors the compiler turns
+// into reciprocal multiplications
+static inline int pid_mmdd(long t_pid) {
+    return (int)((t_pid / 10000) % 10000);
+}
@@ -4,66 +4,104 @@
 #include <string.h>
 
 #include "vercore.h"
-
-// binary output function
-void write_binary_result(long account_number, int is_valid, int valid_only) {
-    if (valid_only && !is_valid)
-        return; // skip invalid accounts in -v mode
-
-    // write account number as binary
-    write(STDOUT_FILENO, &account_number, sizeof(long));
-
-    // write validity flag as binary
-    char validity_flag = is_valid ? 1 : 0;
-    write(STDOUT_FILENO, &validity_flag, sizeof(char));
-}
-
-// text output function
-void write_text_result(long account_number, int is_valid, int valid_only) {
-    if (valid_only && !is_valid)
-        return; // skip invalid accounts in -v mode
-
-    if (valid_only)
-        printf("%010ld\n", account_number);
-    else
-        printf("%010ld %s\n", account_number, is_valid ? "VALID" : "INVALID");
-}
+#include "verpool.h"
+#include "verrange.h"
+#include "vermmap.h"
+#include "verrules.h"
+#include "verstats.h"
+#include "verplugin.h"
 
 int main(int t_argc, char** t_argv) {
-    int valid_only = 0;  // -v flag
-    int binary_mode = 0; // -b flag
+    ver_options options;
+    memset(&options, 0, sizeof(options));
+
+    // at most one plugin per argument
+    ver_plugin* plugins = (ver_plugin*)calloc(t_argc, sizeof(ver_plugin));
+    const char** plugin_paths = (const char**)calloc(t_argc, sizeof(const char*));
+    int plugin_count = 0;
 
     // parse command line arguments
     for (int i = 1; i < t_argc; i++) {
         if (strcmp(t_argv[i], "-v") == 0)
-            valid_only = 1;
+            options.valid_only = 1;
         else if (strcmp(t_argv[i], "-b") == 0)
-            binary_mode = 1;
-        else {
+            options.binary_mode = 1;
+        else if (strcmp(t_argv[i], "-z") == 0)
+            options.binary_mode = options.framed_mode = 1;
+        else if (strcmp(t_argv[i], "-j") == 0 && i + 1 < t_argc && atoi(t_argv[i + 1]) > 0)
+            options.threads = atoi(t_argv[++i]);
+        else if (strcmp(t_argv[i], "--range") == 0 && i + 2 < t_argc) {
+            options.range_mode = 1;
+            options.range_start = atol(t_argv[++i]);
+            options.range_count = atol(t_argv[++i]);
+        } else if (strcmp(t_argv[i], "-m") == 0 && i + 1 < t_argc)
+            options.map_file = t_argv[++i];
+        else if (strcmp(t_argv[i], "--rules") == 0 && i + 1 < t_argc) {
+            options.rules = parse_rules(t_argv[++i]);
+            if (!options.rules)
+                return 1;
+        } else if (strcmp(t_argv[i], "--plugin") == 0 && i + 1 < t_argc)
+            plugin_paths[plugin_count++] = t_argv[++i];
+        else if (strcmp(t_argv[i], "--stats") == 0)
+            options.stats = 1;
+        else if (strncmp(t_argv[i], "--stats=", 8) == 0 && atof(t_argv[i] + 8) > 0) {
+            options.stats = 1;
+            options.stats_interval = atof(t_argv[i] + 8);
+        } else if (strcmp(t_argv[i], "--stats-file") == 0 && i + 1 < t_argc) {
+            options.stats = 1;
+            options.stats_file = t_argv[++i];
+        } else {
             fprintf(stderr, "unknown argument: %s\n", t_argv[i]);
-            fprintf(stderr, "usage: %s [-v] [-b]\n", t_argv[0]);
+            fprintf(stderr, "usage: %s [-v] [-b|-z] [-j n] [-m file] [--range s n] [--rules list]\n", t_argv[0]);
+            fprintf(stderr, "       [--plugin path.so]... [--stats[=interval]] [--stats-file path]\n");
             fprintf(stderr, "-v: show only valid accounts\n");
             fprintf(stderr, "-b: binary input/output mode\n");
+            fprintf(stderr, "-z: framed binary input/output mode (delta+varint, validity bitmap; gennum -z)\n");
+            fprintf(stderr, "-j: verify on n worker threads (output keeps input order)\n");
+            fprintf(stderr, "-m: verify a 'gennum -b' dump file via mmap instead of stdin (implies -b; -z frames the output)\n");
+            fprintf(stderr, "--range: valid numbers of s..s+n-1 without reading stdin; same output as\n");
+            fprintf(stderr, "         'gennum s n | verbank -v', only CNB candidates with --rules account\n");
+            fprintf(stderr, "--rules: verify with the built-in rules instead of libvercore;\n");
+            fprintf(stderr, "         comma separated list of account, pid, pid-date, mod11\n");
+            fprintf(stderr, "--plugin: verify with a libvercore-style library loaded at runtime; several\n");
+            fprintf(stderr, "          plugins chain, a number is valid if every plugin accepts it\n");
+            fprintf(stderr, "--stats: throughput and rejection counts to stderr at the end, and every\n");
+            fprintf(stderr, "         interval seconds if given; with --rules also the rule that rejected\n");
+            fprintf(stderr, "--stats-file: latest stats into a file instead, e.g. /dev/shm/verbank.stats\n");
 
             return 1;
         }
     }
 
-    if (binary_mode) {
-        // binary mode - read binary data
-        long account_number;
-        while (read(STDIN_FILENO, &account_number, sizeof(long)) == sizeof(long)) {
-            int is_valid = verify_number(account_number);
-            write_binary_result(account_number, is_valid, valid_only);
-        }
-    } else {
-        // text mode - read text numbers
-        long account_number;
-        while (scanf("%ld", &account_number) == 1) {
-            int is_valid = verify_number(account_number);
-            write_text_result(account_number, is_valid, valid_only);
-        }
+    if (plugin_count && options.rules) {
+        fprintf(stderr, "error: --plugin and --rules can not be combined\n");
+
+        return 1;
     }
 
-    return 0;
+    for (int i = 0; i < plugin_count; i++)
+        if (load_plugin(plugin_paths[i], &plugins[i]) != 0)
+            return 1;
+    options.plugins = plugins;
+    options.plugin_count = plugin_count;
+
+    if (stats_start(&options) != 0)
+        return 1;
+
+    int result;
+    if (options.range_mode)
+        result = run_range(&options);
+    else if (options.map_file)
+        result = run_mapped(&options);
+    else
+        result = run_verification(&options);
+
+    stats_finish(&options);
+
+    for (int i = 0; i < plugin_count; i++)
+        unload_plugin(&plugins[i]);
+    free(plugins);
+    free(plugin_paths);
+
+    return result;
 }
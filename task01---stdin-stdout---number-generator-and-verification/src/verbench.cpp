@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/wait.h>
+
+#include "gennumcore.h"
+#include "vercore.h"
+
+// throughput benchmark of the generator/verifier pipeline ('make bench')
+//
+// every measurement is one CSV row; sizes go by powers of ten from 1e3 up
+// to -n. the in-process verifier runs the statically linked vercore_account
+// copy next to the dlopen-ed libvercore.so variants, which shows the cost of
+// calling through the shared library
+
+#define BENCH_BLOCK    65536    // numbers per in-process verifier call batch
+#define BENCH_MIN_TIME 0.2      // seconds; small sizes repeat up to this
+#define BENCH_START    1000000000L // 10-digit numbers exercise every rule
+
+typedef int  (*verify_number_fn)(long);
+typedef void (*verify_numbers_fn)(const long*, size_t, uint8_t*);
+
+// the libraries are C++, so the entry points are looked up by mangled name
+#define SYM_VERIFY_NUMBER  "_Z13verify_numberl"
+#define SYM_VERIFY_NUMBERS "_Z14verify_numbersPKlmPh"
+
+static const char* k_libraries[] = { "account", "pid", "all" };
+
+static volatile long g_sink; // keeps results alive
+
+static double now() {
+    timespec l_ts;
+    clock_gettime(CLOCK_MONOTONIC, &l_ts);
+
+    return l_ts.tv_sec + l_ts.tv_nsec * 1e-9;
+}
+
+// t_numbers may be a multiple of t_size when a small size was repeated
+static void report(FILE* t_csv, const char* t_bench, const char* t_variant, const char* t_mode, long t_size, long t_numbers, double t_seconds) {
+    fprintf(t_csv, "%s,%s,%s,%ld,%ld,%.6f,%.0f,%.3f\n", t_bench, t_variant, t_mode, t_size, t_numbers, t_seconds,
+            t_numbers / t_seconds, t_seconds * 1e9 / t_numbers);
+    fflush(t_csv);
+
+    fprintf(stderr, "%-9s %-14s %-7s %11ld  %12.0f numbers/s  %8.3f ns/number\n", t_bench, t_variant, t_mode, t_size,
+            t_numbers / t_seconds, t_seconds * 1e9 / t_numbers);
+}
+
+// ----------------------------------------------------------------------------
+// in-process
+
+// generator into /dev/null; stdout is redirected for the duration of the call
+static void bench_generator(FILE* t_csv, const char* t_mode, void (*t_generate)(long, long), long t_count) {
+    fflush(stdout);
+    int l_saved = dup(STDOUT_FILENO);
+    int l_null = open("/dev/null", O_WRONLY);
+    if (l_saved < 0 || l_null < 0) {
+        perror("error: /dev/null");
+        exit(1);
+    }
+    dup2(l_null, STDOUT_FILENO);
+    close(l_null);
+
+    long   l_done = 0;
+    double l_start = now();
+    do {
+        t_generate(BENCH_START, t_count);
+        l_done += t_count;
+    } while (now() - l_start < BENCH_MIN_TIME);
+    double l_time = now() - l_start;
+
+    dup2(l_saved, STDOUT_FILENO);
+    close(l_saved);
+
+    report(t_csv, "generate", "gennumcore", t_mode, t_count, l_done, l_time);
+}
+
+// t_count numbers through one verifier, per number and in batches
+static void bench_verifier(FILE* t_csv, const char* t_variant, verify_number_fn t_single, verify_numbers_fn t_batch, long t_count) {
+    static long    l_numbers[BENCH_BLOCK];
+    static uint8_t l_valid[BENCH_BLOCK];
+
+    long l_sum = 0;
+    for (int l_mode = 0; l_mode < 2; l_mode++) {
+        if (l_mode == 1 && !t_batch)
+            break;
+
+        long   l_done = 0;
+        double l_start = now();
+        do {
+            for (long l_pos = 0; l_pos < t_count; l_pos += BENCH_BLOCK) {
+                long l_block = t_count - l_pos < BENCH_BLOCK ? t_count - l_pos : BENCH_BLOCK;
+                for (long i = 0; i < l_block; i++)
+                    l_numbers[i] = BENCH_START + l_pos + i;
+
+                if (l_mode == 0)
+                    for (long i = 0; i < l_block; i++)
+                        l_sum += t_single(l_numbers[i]);
+                else {
+                    t_batch(l_numbers, (size_t)l_block, l_valid);
+                    for (long i = 0; i < l_block; i++)
+                        l_sum += l_valid[i];
+                }
+            }
+            l_done += t_count;
+        } while (now() - l_start < BENCH_MIN_TIME);
+
+        report(t_csv, "verify", t_variant, l_mode ? "batch" : "single", t_count, l_done, now() - l_start);
+    }
+
+    g_sink = l_sum;
+}
+
+static void bench_libraries(FILE* t_csv, long t_count) {
+    bench_verifier(t_csv, "static-account", verify_number, verify_numbers, t_count);
+
+    for (const char* l_name : k_libraries) {
+        char l_path[64];
+        snprintf(l_path, sizeof(l_path), "./vercore_%s/libvercore.so", l_name);
+
+        void* l_handle = dlopen(l_path, RTLD_NOW | RTLD_LOCAL);
+        if (!l_handle) {
+            fprintf(stderr, "error: %s\n", dlerror());
+            continue;
+        }
+
+        verify_number_fn  l_single = (verify_number_fn)dlsym(l_handle, SYM_VERIFY_NUMBER);
+        verify_numbers_fn l_batch  = (verify_numbers_fn)dlsym(l_handle, SYM_VERIFY_NUMBERS);
+
+        char l_variant[32];
+        snprintf(l_variant, sizeof(l_variant), "shared-%s", l_name);
+        if (l_single)
+            bench_verifier(t_csv, l_variant, l_single, l_batch, t_count);
+        else
+            fprintf(stderr, "error: %s has no verify_number\n", l_path);
+
+        dlclose(l_handle);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// pipes: ./gennum [flag] S N | ./verbank [flag] > /dev/null
+
+static pid_t spawn(const char* t_path, char* const* t_argv, int t_in, int t_out, const char* t_library) {
+    pid_t l_pid = fork();
+    if (l_pid != 0)
+        return l_pid;
+
+    dup2(t_in, STDIN_FILENO);
+    dup2(t_out, STDOUT_FILENO);
+    for (int fd = 3; fd < 64; fd++)
+        close(fd);
+
+    setenv("LD_LIBRARY_PATH", t_library, 1);
+    execv(t_path, t_argv);
+    perror(t_path);
+    _exit(127);
+}
+
+static double run_pipe(const char* t_flag, long t_count, const char* t_library) {
+    char l_start[32], l_count[32];
+    snprintf(l_start, sizeof(l_start), "%ld", BENCH_START);
+    snprintf(l_count, sizeof(l_count), "%ld", t_count);
+
+    char l_gen_name[] = "gennum", l_ver_name[] = "verbank";
+    char l_flag[8];
+    snprintf(l_flag, sizeof(l_flag), "%s", t_flag);
+
+    // text mode passes no flag at all
+    char* l_gen_argv[] = { l_gen_name, l_flag, l_start, l_count, nullptr };
+    char* l_gen_text[] = { l_gen_name, l_start, l_count, nullptr };
+    char* l_ver_argv[] = { l_ver_name, l_flag, nullptr };
+    char* l_ver_text[] = { l_ver_name, nullptr };
+
+    int l_pipe[2];
+    int l_null = open("/dev/null", O_RDWR);
+    if (pipe(l_pipe) != 0 || l_null < 0) {
+        perror("error: pipe");
+        exit(1);
+    }
+
+    double l_begin = now();
+    pid_t l_gen = spawn("./gennum", *t_flag ? l_gen_argv : l_gen_text, l_null, l_pipe[1], t_library);
+    pid_t l_ver = spawn("./verbank", *t_flag ? l_ver_argv : l_ver_text, l_pipe[0], l_null, t_library);
+    close(l_pipe[0]);
+    close(l_pipe[1]);
+    close(l_null);
+
+    int l_status, l_failed = 0;
+    waitpid(l_gen, &l_status, 0);
+    l_failed |= !WIFEXITED(l_status) || WEXITSTATUS(l_status) != 0;
+    waitpid(l_ver, &l_status, 0);
+    l_failed |= !WIFEXITED(l_status) || WEXITSTATUS(l_status) != 0;
+    double l_time = now() - l_begin;
+
+    return l_failed ? -1 : l_time;
+}
+
+static void bench_pipes(FILE* t_csv, long t_count) {
+    static const struct { const char* mode; const char* flag; } k_modes[] = {
+        { "text",   ""   },
+        { "binary", "-b" },
+        { "framed", "-z" },
+    };
+
+    for (const auto& l_mode : k_modes)
+        for (const char* l_name : k_libraries) {
+            char l_library[32], l_variant[32];
+            snprintf(l_library, sizeof(l_library), "vercore_%s", l_name);
+            snprintf(l_variant, sizeof(l_variant), "shared-%s", l_name);
+
+            double l_time = run_pipe(l_mode.flag, t_count, l_library);
+            if (l_time < 0)
+                fprintf(stderr, "error: pipe %s %s failed\n", l_mode.mode, l_variant);
+            else
+                report(t_csv, "pipe", l_variant, l_mode.mode, t_count, t_count, l_time);
+        }
+}
+
+// ----------------------------------------------------------------------------
+
+int main(int t_argc, char** t_argv) {
+    long        l_max = 10000000;
+    const char* l_output = nullptr;
+
+    for (int i = 1; i < t_argc; i++) {
+        if (strcmp(t_argv[i], "-n") == 0 && i + 1 < t_argc)
+            l_max = (long)atof(t_argv[++i]);
+        else if (strcmp(t_argv[i], "-o") == 0 && i + 1 < t_argc)
+            l_output = t_argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [-n max] [-o file.csv]\n", t_argv[0]);
+            fprintf(stderr, "-n: largest input size, 1e3..1e9 (default: 1e7)\n");
+            fprintf(stderr, "-o: CSV output file (default: stdout)\n");
+            fprintf(stderr, "run from the build directory; the pipes use ./gennum and ./verbank\n");
+
+            return 1;
+        }
+    }
+
+    if (l_max < 1000 || l_max > 1000000000L) {
+        fprintf(stderr, "error: max size must be between 1e3 and 1e9\n");
+
+        return 1;
+    }
+
+    FILE* l_csv = l_output ? fopen(l_output, "w") : stdout;
+    if (!l_csv) {
+        perror(l_output);
+
+        return 1;
+    }
+
+    fprintf(l_csv, "bench,variant,mode,size,numbers,seconds,numbers_per_s,ns_per_number\n");
+    for (long l_count = 1000; l_count <= l_max; l_count *= 10) {
+        bench_generator(l_csv, "text", generate_numbers, l_count);
+        bench_generator(l_csv, "binary", generate_numbers_binary, l_count);
+        bench_generator(l_csv, "framed", generate_numbers_framed, l_count);
+        bench_libraries(l_csv, l_count);
+        bench_pipes(l_csv, l_count);
+    }
+
+    if (l_output)
+        fclose(l_csv);
+
+    return 0;
+}
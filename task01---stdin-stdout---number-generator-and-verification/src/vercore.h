@@ -1 +1,7 @@
+#include <stddef.h>
+#include <stdint.h>
+
 int verify_number(long account_number);
+
+// batch verification; out[i] = 1 if in[i] is valid, 0 otherwise
+void verify_numbers(const long* in, size_t n, uint8_t* out);
@@ -3,6 +3,11 @@
 
 #include "../vercore.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERCORE_X86 1
+#endif
+
 // bank account verification function
 int verify_number(long account_number) {
     // weights for CNB control algorithm
@@ -20,3 +25,145 @@ int verify_number(long account_number) {
     // account is valid if sum is divisible by 11
     return (sum % 11) == 0;
 }
+
+// ----------------------------------------------------------------------------
+// batch verification
+//
+// the CNB weights are 2^i mod 11, so only the lowest 10 digits matter and the
+// sign does not (a negative number has all digits negated, so its sum is too).
+// each number is normalized to |n| mod 10^10 and split into three 4-digit
+// groups (c0 = digits 0-3, c1 = digits 4-7, c2 = digits 8-9) which fit into
+// 16-bit lanes; the SIMD kernels then extract digits with a reciprocal
+// multiply (x / 10 == (x * 6554) >> 16 for x < 10000) and reduce the weighted
+// sum mod 11 the same way (s / 11 == (s * 5958) >> 16 for s <= 495)
+// ----------------------------------------------------------------------------
+
+static inline void split_number(long t_number, uint16_t* c0, uint16_t* c1, uint16_t* c2) {
+    unsigned long u = t_number < 0 ? -(unsigned long)t_number : (unsigned long)t_number;
+    u %= 10000000000UL;
+
+    unsigned long hi = u / 10000;
+    *c0 = (uint16_t)(u % 10000);
+    *c1 = (uint16_t)(hi % 10000);
+    *c2 = (uint16_t)(hi / 10000);
+}
+
+// scalar fallback; also handles the tail of a batch
+static void verify_numbers_scalar(const long* in, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = (uint8_t)verify_number(in[i]);
+}
+
+#ifdef VERCORE_X86
+
+// SSE2 is the x86_64 baseline; the kernel only needs 16-bit multiplies
+#define SSE_LANES 8
+
+__attribute__((target("sse2")))
+static inline __m128i weigh_group_sse(__m128i t_group, const int* t_weights, int t_digits) {
+    const __m128i k_div10 = _mm_set1_epi16(6554);
+    const __m128i k_ten   = _mm_set1_epi16(10);
+
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < t_digits; i++) {
+        __m128i q = _mm_mulhi_epu16(t_group, k_div10);
+        __m128i d = _mm_sub_epi16(t_group, _mm_mullo_epi16(q, k_ten));
+        sum = _mm_add_epi16(sum, _mm_mullo_epi16(d, _mm_set1_epi16(t_weights[i])));
+        t_group = q;
+    }
+
+    return sum;
+}
+
+__attribute__((target("sse2")))
+static void verify_numbers_sse(const long* in, size_t n, uint8_t* out) {
+    static const int k_weights[] = { 1, 2, 4, 8, 5, 10, 9, 7, 3, 6 };
+
+    size_t i = 0;
+    for (; i + SSE_LANES <= n; i += SSE_LANES) {
+        alignas(16) uint16_t c0[SSE_LANES], c1[SSE_LANES], c2[SSE_LANES];
+        for (int j = 0; j < SSE_LANES; j++)
+            split_number(in[i + j], &c0[j], &c1[j], &c2[j]);
+
+        __m128i sum = weigh_group_sse(_mm_load_si128((const __m128i*)c0), k_weights, 4);
+        sum = _mm_add_epi16(sum, weigh_group_sse(_mm_load_si128((const __m128i*)c1), k_weights + 4, 4));
+        sum = _mm_add_epi16(sum, weigh_group_sse(_mm_load_si128((const __m128i*)c2), k_weights + 8, 2));
+
+        // sum mod 11 == 0
+        __m128i q   = _mm_mulhi_epu16(sum, _mm_set1_epi16(5958));
+        __m128i rem = _mm_sub_epi16(sum, _mm_mullo_epi16(q, _mm_set1_epi16(11)));
+        __m128i ok  = _mm_and_si128(_mm_cmpeq_epi16(rem, _mm_setzero_si128()), _mm_set1_epi16(1));
+
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(ok, ok));
+    }
+
+    verify_numbers_scalar(in + i, n - i, out + i);
+}
+
+#define AVX2_LANES 16
+
+__attribute__((target("avx2")))
+static inline __m256i weigh_group_avx2(__m256i t_group, const int* t_weights, int t_digits) {
+    const __m256i k_div10 = _mm256_set1_epi16(6554);
+    const __m256i k_ten   = _mm256_set1_epi16(10);
+
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < t_digits; i++) {
+        __m256i q = _mm256_mulhi_epu16(t_group, k_div10);
+        __m256i d = _mm256_sub_epi16(t_group, _mm256_mullo_epi16(q, k_ten));
+        sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(d, _mm256_set1_epi16(t_weights[i])));
+        t_group = q;
+    }
+
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static void verify_numbers_avx2(const long* in, size_t n, uint8_t* out) {
+    static const int k_weights[] = { 1, 2, 4, 8, 5, 10, 9, 7, 3, 6 };
+
+    size_t i = 0;
+    for (; i + AVX2_LANES <= n; i += AVX2_LANES) {
+        alignas(32) uint16_t c0[AVX2_LANES], c1[AVX2_LANES], c2[AVX2_LANES];
+        for (int j = 0; j < AVX2_LANES; j++)
+            split_number(in[i + j], &c0[j], &c1[j], &c2[j]);
+
+        __m256i sum = weigh_group_avx2(_mm256_load_si256((const __m256i*)c0), k_weights, 4);
+        sum = _mm256_add_epi16(sum, weigh_group_avx2(_mm256_load_si256((const __m256i*)c1), k_weights + 4, 4));
+        sum = _mm256_add_epi16(sum, weigh_group_avx2(_mm256_load_si256((const __m256i*)c2), k_weights + 8, 2));
+
+        // sum mod 11 == 0
+        __m256i q   = _mm256_mulhi_epu16(sum, _mm256_set1_epi16(5958));
+        __m256i rem = _mm256_sub_epi16(sum, _mm256_mullo_epi16(q, _mm256_set1_epi16(11)));
+        __m256i ok  = _mm256_and_si256(_mm256_cmpeq_epi16(rem, _mm256_setzero_si256()), _mm256_set1_epi16(1));
+
+        // packus works per 128-bit lane; the low 8 bytes of each lane hold the results
+        __m256i packed = _mm256_packus_epi16(ok, ok);
+        _mm_storel_epi64((__m128i*)(out + i),     _mm256_castsi256_si128(packed));
+        _mm_storel_epi64((__m128i*)(out + i + 8), _mm256_extracti128_si256(packed, 1));
+    }
+
+    verify_numbers_sse(in + i, n - i, out + i);
+}
+
+#endif // VERCORE_X86
+
+// runtime CPU dispatch; resolved on first call
+typedef void (*verify_numbers_fn)(const long*, size_t, uint8_t*);
+
+static verify_numbers_fn select_verify_numbers() {
+#ifdef VERCORE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return verify_numbers_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return verify_numbers_sse;
+#endif
+    return verify_numbers_scalar;
+}
+
+void verify_numbers(const long* in, size_t n, uint8_t* out) {
+    static const verify_numbers_fn l_impl = select_verify_numbers();
+
+    l_impl(in, n, out);
+}
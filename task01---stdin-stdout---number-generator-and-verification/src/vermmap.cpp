@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "binstream.h"
+#include "verpool.h"
+#include "vermmap.h"
+
+// ----------------------------------------------------------------------------
+// memory-mapped input
+//
+// the file is mapped one window at a time, so files larger than RAM (or the
+// address space of a 32-bit build) work; every window is split into
+// page-aligned slices verified in place by one thread each. slices are
+// written in order as their threads finish, and a finished window is
+// unmapped and dropped from the page cache
+// ----------------------------------------------------------------------------
+
+#define MAP_WINDOW (64L * 1024 * 1024) // bytes mapped at once; multiple of the page size
+
+struct map_slice {
+    const ver_options* options;
+    const long* numbers;
+    size_t      count;
+    ver_chunk   chunk;
+};
+
+static void* slice_thread(void* t_arg) {
+    map_slice* l_slice = (map_slice*)t_arg;
+    ver_chunk* l_chunk = &l_slice->chunk;
+
+    l_chunk->out.len = 0;
+    for (size_t l_done = 0; l_done < l_slice->count; l_done += l_chunk->count) {
+        l_chunk->view = l_slice->numbers + l_done;
+        l_chunk->count = l_slice->count - l_done;
+        if (l_chunk->count > CHUNK_NUMBERS)
+            l_chunk->count = CHUNK_NUMBERS;
+
+        verify_chunk(l_chunk, l_slice->options);
+    }
+
+    return nullptr;
+}
+
+int run_mapped(const ver_options* t_options) {
+    int l_fd = open(t_options->map_file, O_RDONLY);
+    if (l_fd < 0) {
+        fprintf(stderr, "error: cannot open '%s': %s\n", t_options->map_file, strerror(errno));
+        return 1;
+    }
+
+    struct stat l_stat;
+    if (fstat(l_fd, &l_stat) != 0) {
+        fprintf(stderr, "error: cannot stat '%s': %s\n", t_options->map_file, strerror(errno));
+        close(l_fd);
+        return 1;
+    }
+
+    // a trailing partial number is dropped, as in the stdin modes
+    off_t l_size = l_stat.st_size - l_stat.st_size % sizeof(long);
+
+    ver_options l_options = *t_options;
+    l_options.binary_mode = 1;
+
+    int l_threads = t_options->threads > 1 ? t_options->threads : 1;
+    long l_page = sysconf(_SC_PAGESIZE);
+
+    map_slice* l_slices = (map_slice*)calloc(l_threads, sizeof(map_slice));
+    pthread_t* l_tids = (pthread_t*)calloc(l_threads, sizeof(pthread_t));
+    for (int i = 0; i < l_threads; i++) {
+        l_slices[i].options = &l_options;
+        chunk_reserve_numbers(&l_slices[i].chunk, CHUNK_NUMBERS);
+    }
+
+    int l_result = write_stream_header(&l_options) != 0;
+    for (off_t l_offset = 0; l_offset < l_size && !l_result; l_offset += MAP_WINDOW) {
+        size_t l_window = l_size - l_offset < MAP_WINDOW ? (size_t)(l_size - l_offset) : MAP_WINDOW;
+
+        void* l_map = mmap(nullptr, l_window, PROT_READ, MAP_PRIVATE, l_fd, l_offset);
+        if (l_map == MAP_FAILED) {
+            fprintf(stderr, "error: cannot map '%s': %s\n", t_options->map_file, strerror(errno));
+            l_result = 1;
+            break;
+        }
+        madvise(l_map, l_window, MADV_SEQUENTIAL); // advice values are not flags; one call each
+        madvise(l_map, l_window, MADV_WILLNEED);
+
+        // page-aligned slices; the last ones may be short or empty
+        size_t l_slice_bytes = (l_window / l_threads + l_page - 1) / l_page * l_page;
+        int l_started = 0;
+        for (size_t l_pos = 0; l_pos < l_window && l_started < l_threads; l_pos += l_slice_bytes) {
+            size_t l_bytes = l_window - l_pos < l_slice_bytes ? l_window - l_pos : l_slice_bytes;
+
+            l_slices[l_started].numbers = (const long*)((const char*)l_map + l_pos);
+            l_slices[l_started].count = l_bytes / sizeof(long);
+            pthread_create(&l_tids[l_started], nullptr, slice_thread, &l_slices[l_started]);
+            l_started++;
+        }
+
+        for (int i = 0; i < l_started; i++) {
+            pthread_join(l_tids[i], nullptr);
+
+            ver_chunk* l_chunk = &l_slices[i].chunk;
+            if (!l_result && bin_write_all(STDOUT_FILENO, l_chunk->out.data, l_chunk->out.len) != 0)
+                l_result = 1;
+        }
+
+        munmap(l_map, l_window);
+        posix_fadvise(l_fd, l_offset, l_window, POSIX_FADV_DONTNEED);
+    }
+
+    for (int i = 0; i < l_threads; i++)
+        free_chunk(&l_slices[i].chunk);
+    free(l_slices);
+    free(l_tids);
+    close(l_fd);
+
+    return l_result;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "verpool.h"
+
+// -m file; verify a binary dump from 'gennum -b' through mmap instead of
+// stdin, writing -b records; returns process exit code
+int run_mapped(const ver_options* t_options);
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlfcn.h>
+
+#include "verplugin.h"
+
+// entry points; extern "C" names first, then the mangled vercore.h ones
+static const char* k_one_symbols[]   = { "verify_number", "_Z13verify_numberl" };
+static const char* k_batch_symbols[] = { "verify_numbers", "_Z14verify_numbersPKlmPh" };
+
+static void* find_symbol(void* t_handle, const char* const* t_names, int t_count) {
+    for (int i = 0; i < t_count; i++) {
+        void* l_symbol = dlsym(t_handle, t_names[i]);
+        if (l_symbol)
+            return l_symbol;
+    }
+
+    return nullptr;
+}
+
+int load_plugin(const char* t_path, ver_plugin* t_plugin) {
+    // RTLD_DEEPBIND: the plugin's own calls (verify_numbers -> verify_number)
+    // must not resolve to the libvercore verbank is linked with
+    void* l_handle = dlopen(t_path, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    if (!l_handle) {
+        fprintf(stderr, "error: %s\n", dlerror());
+        return 1;
+    }
+
+    t_plugin->path = t_path;
+    t_plugin->handle = l_handle;
+    t_plugin->verify_one = (verify_number_fn)find_symbol(l_handle, k_one_symbols, 2);
+    t_plugin->verify_batch = (verify_numbers_fn)find_symbol(l_handle, k_batch_symbols, 2);
+
+    if (!t_plugin->verify_one) {
+        fprintf(stderr, "error: %s: no verify_number entry point\n", t_path);
+        dlclose(l_handle);
+        t_plugin->handle = nullptr;
+        return 1;
+    }
+
+    return 0;
+}
+
+void unload_plugin(ver_plugin* t_plugin) {
+    if (t_plugin->handle)
+        dlclose(t_plugin->handle);
+    t_plugin->handle = nullptr;
+}
+
+static void run_plugin(const ver_plugin* t_plugin, const long* in, size_t n, uint8_t* out) {
+    if (t_plugin->verify_batch) {
+        t_plugin->verify_batch(in, n, out);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = (uint8_t)(t_plugin->verify_one(in[i]) != 0);
+}
+
+// per-thread buffers of the numbers still in the chain
+struct chain_buffers {
+    long*    numbers;
+    size_t*  index;
+    uint8_t* valid;
+    size_t   capacity;
+};
+
+static thread_local chain_buffers tl_chain;
+
+static int chain_reserve(chain_buffers* t_chain, size_t t_count) {
+    if (t_chain->capacity >= t_count)
+        return 0;
+
+    long*    l_numbers = (long*)realloc(t_chain->numbers, t_count * sizeof(long));
+    if (l_numbers)
+        t_chain->numbers = l_numbers;
+    size_t*  l_index = (size_t*)realloc(t_chain->index, t_count * sizeof(size_t));
+    if (l_index)
+        t_chain->index = l_index;
+    uint8_t* l_valid = (uint8_t*)realloc(t_chain->valid, t_count);
+    if (l_valid)
+        t_chain->valid = l_valid;
+
+    if (!l_numbers || !l_index || !l_valid)
+        return -1;
+
+    t_chain->capacity = t_count;
+
+    return 0;
+}
+
+void verify_numbers_plugins(const ver_plugin* t_plugins, int t_count, const long* in, size_t n, uint8_t* out) {
+    run_plugin(&t_plugins[0], in, n, out);
+
+    chain_buffers* l_chain = &tl_chain;
+    for (int p = 1; p < t_count; p++) {
+        if (chain_reserve(l_chain, n) != 0) {
+            // no memory for the compacted list; every number through the plugin
+            for (size_t i = 0; i < n; i++)
+                if (out[i])
+                    out[i] = (uint8_t)(t_plugins[p].verify_one(in[i]) != 0);
+            continue;
+        }
+
+        // gather the survivors, verify them, scatter the verdicts back
+        size_t l_alive = 0;
+        for (size_t i = 0; i < n; i++)
+            if (out[i]) {
+                l_chain->numbers[l_alive] = in[i];
+                l_chain->index[l_alive++] = i;
+            }
+
+        if (l_alive == 0)
+            break;
+
+        run_plugin(&t_plugins[p], l_chain->numbers, l_alive, l_chain->valid);
+        for (size_t i = 0; i < l_alive; i++)
+            out[l_chain->index[i]] = l_chain->valid[i];
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --plugin path.so; validators loaded at runtime instead of the linked libvercore
+//
+// a plugin exports verify_number() and optionally the batch verify_numbers()
+// of vercore.h, either C++ mangled (as the vercore_* libraries) or extern "C".
+// several plugins form a chain: a number is valid if every plugin accepts it,
+// the same as 'verbank -v | verbank -v' but without a process and a text
+// re-parse per hop
+
+typedef int  (*verify_number_fn)(long);
+typedef void (*verify_numbers_fn)(const long*, size_t, uint8_t*);
+
+struct ver_plugin {
+    const char*       path;
+    void*             handle;
+    verify_number_fn  verify_one;
+    verify_numbers_fn verify_batch; // nullptr if the plugin has none
+};
+
+// load a plugin; returns 0 on success
+int  load_plugin(const char* t_path, ver_plugin* t_plugin);
+void unload_plugin(ver_plugin* t_plugin);
+
+// out[i] = 1 if every plugin accepts in[i]; each plugin after the first only
+// sees the numbers all the previous ones accepted
+void verify_numbers_plugins(const ver_plugin* t_plugins, int t_count, const long* in, size_t n, uint8_t* out);
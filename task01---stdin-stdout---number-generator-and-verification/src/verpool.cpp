@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "vercore.h"
+#include "binstream.h"
+#include "numcodec.h"
+#include "verrules.h"
+#include "numframe.h"
+#include "verpool.h"
+#include "verstats.h"
+#include "verplugin.h"
+
+static void* xrealloc(void* t_ptr, size_t t_size) {
+    void* l_ptr = realloc(t_ptr, t_size);
+    if (!l_ptr) {
+        fprintf(stderr, "error: out of memory\n");
+        exit(1);
+    }
+
+    return l_ptr;
+}
+
+// ----------------------------------------------------------------------------
+// output formatting
+
+static void out_reserve(out_buffer* t_out, size_t t_extra) {
+    if (t_out->len + t_extra <= t_out->capacity)
+        return;
+
+    size_t l_capacity = t_out->capacity ? t_out->capacity * 2 : 64 * 1024;
+    while (l_capacity < t_out->len + t_extra)
+        l_capacity *= 2;
+
+    t_out->data = (char*)xrealloc(t_out->data, l_capacity);
+    t_out->capacity = l_capacity;
+}
+
+// binary output function
+void write_binary_result(out_buffer* out, long account_number, int is_valid, int valid_only) {
+    if (valid_only && !is_valid)
+        return; // skip invalid accounts in -v mode
+
+    // account number followed by validity flag; 9 bytes per record
+    out_reserve(out, sizeof(long) + sizeof(char));
+    memcpy(out->data + out->len, &account_number, sizeof(long));
+    out->data[out->len + sizeof(long)] = is_valid ? 1 : 0;
+    out->len += sizeof(long) + sizeof(char);
+}
+
+// text output function
+void write_text_result(out_buffer* out, long account_number, int is_valid, int valid_only) {
+    if (valid_only && !is_valid)
+        return; // skip invalid accounts in -v mode
+
+    static const char k_valid[]   = " VALID\n";
+    static const char k_invalid[] = " INVALID\n";
+
+    out_reserve(out, NUM_TEXT_MAX + sizeof(k_invalid));
+    char* l_pos = out->data + out->len;
+    l_pos += format_number(account_number, l_pos);
+
+    if (valid_only)
+        *l_pos++ = '\n';
+    else if (is_valid) {
+        memcpy(l_pos, k_valid, sizeof(k_valid) - 1);
+        l_pos += sizeof(k_valid) - 1;
+    } else {
+        memcpy(l_pos, k_invalid, sizeof(k_invalid) - 1);
+        l_pos += sizeof(k_invalid) - 1;
+    }
+
+    out->len = l_pos - out->data;
+}
+
+// framed output; the kept results are encoded as self-contained frames
+static void write_framed_results(out_buffer* out, const long* numbers, const uint8_t* valid, size_t count, int valid_only) {
+    long    l_kept[FRAME_NUMBERS];
+    uint8_t l_kept_valid[FRAME_NUMBERS];
+    size_t  l_count = 0;
+
+    for (size_t i = 0; i <= count; i++) {
+        if (l_count == FRAME_NUMBERS || (i == count && l_count > 0)) {
+            out_reserve(out, FRAME_MAX_BYTES);
+            out->len += frame_encode(l_kept, l_kept_valid, l_count, out->data + out->len);
+            l_count = 0;
+        }
+        if (i == count)
+            break;
+
+        if (valid_only && !valid[i])
+            continue; // skip invalid accounts in -v mode
+
+        l_kept[l_count] = numbers[i];
+        l_kept_valid[l_count++] = valid[i];
+    }
+}
+
+int write_stream_header(const ver_options* t_options) {
+    if (!t_options->framed_mode)
+        return 0;
+
+    char l_header[FRAME_HEADER];
+    frame_header(FRAME_RESULTS, l_header);
+
+    return bin_write_all(STDOUT_FILENO, l_header, FRAME_HEADER);
+}
+
+// ----------------------------------------------------------------------------
+// chunk processing
+
+void chunk_reserve_numbers(ver_chunk* t_chunk, size_t t_count) {
+    if (t_count <= t_chunk->numbers_capacity)
+        return;
+
+    t_chunk->numbers = (long*)xrealloc(t_chunk->numbers, t_count * sizeof(long));
+    t_chunk->valid = (uint8_t*)xrealloc(t_chunk->valid, t_count);
+    t_chunk->numbers_capacity = t_count;
+}
+
+void process_chunk(ver_chunk* t_chunk, const ver_options* t_options) {
+    if (!t_options->binary_mode) {
+        chunk_reserve_numbers(t_chunk, t_chunk->text_len / 2 + 1);
+        t_chunk->count = parse_numbers(t_chunk->text, t_chunk->text_len, t_chunk->numbers, &t_chunk->stop);
+    }
+
+    t_chunk->out.len = 0;
+    verify_chunk(t_chunk, t_options);
+}
+
+void verify_chunk(ver_chunk* t_chunk, const ver_options* t_options) {
+    const long* l_numbers = t_chunk->view ? t_chunk->view : t_chunk->numbers;
+
+    // the rule engine tells why it rejected; the libraries can not
+    uint64_t l_reasons[REASON_COUNT] = { 0 };
+    uint64_t* l_stats_reasons = t_options->stats && t_options->rules ? l_reasons : nullptr;
+
+    uint64_t l_start = t_options->stats ? stats_now() : 0;
+    if (t_options->rules)
+        verify_numbers_rules(t_options->rules, l_numbers, t_chunk->count, t_chunk->valid, l_stats_reasons);
+    else if (t_options->plugin_count)
+        verify_numbers_plugins(t_options->plugins, t_options->plugin_count, l_numbers, t_chunk->count, t_chunk->valid);
+    else
+        verify_numbers(l_numbers, t_chunk->count, t_chunk->valid);
+
+    if (t_options->stats)
+        stats_chunk(t_chunk->valid, t_chunk->count, l_stats_reasons, stats_now() - l_start);
+
+    if (t_options->framed_mode) {
+        write_framed_results(&t_chunk->out, l_numbers, t_chunk->valid, t_chunk->count, t_options->valid_only);
+        return;
+    }
+
+    for (size_t i = 0; i < t_chunk->count; i++) {
+        if (t_options->binary_mode)
+            write_binary_result(&t_chunk->out, l_numbers[i], t_chunk->valid[i], t_options->valid_only);
+        else
+            write_text_result(&t_chunk->out, l_numbers[i], t_chunk->valid[i], t_options->valid_only);
+    }
+}
+
+void free_chunk(ver_chunk* t_chunk) {
+    free(t_chunk->text);
+    free(t_chunk->numbers);
+    free(t_chunk->valid);
+    free(t_chunk->out.data);
+}
+
+// ----------------------------------------------------------------------------
+// input splitting
+
+struct chunk_reader {
+    bin_stream in;    // binary mode
+    int    frame_flags; // framed mode: stream header flags
+    int    error;     // framed mode: malformed input
+    char*  carry;     // text mode: partial token left over from the previous read
+    size_t carry_len;
+    size_t carry_capacity;
+    int    eof;
+};
+
+static void read_binary_chunk(chunk_reader* t_reader, ver_chunk* t_chunk) {
+    chunk_reserve_numbers(t_chunk, CHUNK_NUMBERS);
+
+    const void* l_view;
+    t_chunk->count = bin_read_records(&t_reader->in, sizeof(long), CHUNK_NUMBERS, &l_view);
+    memcpy(t_chunk->numbers, l_view, t_chunk->count * sizeof(long));
+    t_chunk->stop = 0;
+}
+
+static void chunk_reserve_text(ver_chunk* t_chunk, size_t t_len) {
+    if (t_len <= t_chunk->text_capacity)
+        return;
+
+    // room for the terminating NUL and the parser's read-ahead
+    t_chunk->text = (char*)xrealloc(t_chunk->text, t_len + 1 + NUM_PARSE_PADDING);
+    t_chunk->text_capacity = t_len;
+}
+
+// whole frames until the chunk is full
+static void read_framed_chunk(chunk_reader* t_reader, ver_chunk* t_chunk) {
+    chunk_reserve_numbers(t_chunk, CHUNK_NUMBERS);
+
+    t_chunk->count = 0;
+    t_chunk->stop = 0;
+    while (!t_reader->error && t_chunk->count + FRAME_NUMBERS <= CHUNK_NUMBERS) {
+        long l_count = frame_decode(&t_reader->in, t_reader->frame_flags, t_chunk->numbers + t_chunk->count, nullptr);
+        if (l_count < 0)
+            t_reader->error = 1;
+        if (l_count <= 0)
+            break;
+
+        t_chunk->count += l_count;
+    }
+}
+
+// read text up to a whitespace boundary so no token is split between chunks
+static void read_text_chunk(chunk_reader* t_reader, ver_chunk* t_chunk) {
+    chunk_reserve_text(t_chunk, CHUNK_TEXT);
+
+    // start with the carried over partial token
+    chunk_reserve_text(t_chunk, t_reader->carry_len * 2);
+    memcpy(t_chunk->text, t_reader->carry, t_reader->carry_len);
+    t_chunk->text_len = t_reader->carry_len;
+    t_reader->carry_len = 0;
+
+    size_t l_cut = 0; // end of the last whole token
+    while (!t_reader->eof) {
+        if (t_chunk->text_len == t_chunk->text_capacity) {
+            if (l_cut > 0)
+                break;
+
+            // a single token longer than the buffer; grow it
+            chunk_reserve_text(t_chunk, t_chunk->text_capacity * 2);
+        }
+
+        ssize_t l_len = read(STDIN_FILENO, t_chunk->text + t_chunk->text_len, t_chunk->text_capacity - t_chunk->text_len);
+        if (l_len < 0 && errno == EINTR)
+            continue;
+        if (l_len <= 0) {
+            t_reader->eof = 1;
+            break;
+        }
+
+        t_chunk->text_len += l_len;
+        for (size_t i = t_chunk->text_len; i > l_cut; i--)
+            if (isspace((unsigned char)t_chunk->text[i - 1])) {
+                l_cut = i;
+                break;
+            }
+    }
+
+    if (!t_reader->eof && l_cut < t_chunk->text_len) {
+        size_t l_rest = t_chunk->text_len - l_cut;
+        if (l_rest > t_reader->carry_capacity) {
+            t_reader->carry = (char*)xrealloc(t_reader->carry, l_rest);
+            t_reader->carry_capacity = l_rest;
+        }
+        memcpy(t_reader->carry, t_chunk->text + l_cut, l_rest);
+        t_reader->carry_len = l_rest;
+        t_chunk->text_len = l_cut;
+    }
+
+    memset(t_chunk->text + t_chunk->text_len, 0, 1 + NUM_PARSE_PADDING);
+    t_chunk->count = 0;
+    t_chunk->stop = 0;
+}
+
+// returns 0 when there is no more input
+static int read_chunk(chunk_reader* t_reader, ver_chunk* t_chunk, const ver_options* t_options) {
+    if (t_options->framed_mode) {
+        read_framed_chunk(t_reader, t_chunk);
+        return t_chunk->count > 0;
+    }
+
+    if (t_options->binary_mode) {
+        read_binary_chunk(t_reader, t_chunk);
+        return t_chunk->count > 0;
+    }
+
+    read_text_chunk(t_reader, t_chunk);
+    return t_chunk->text_len > 0;
+}
+
+// ----------------------------------------------------------------------------
+// worker pool with in-order output
+//
+// the reader (calling thread) fills slots in sequence order, workers take
+// them in the same order and the writer thread waits for the next sequence
+// number to complete; the slot ring bounds the number of chunks in flight
+
+enum slot_state { SLOT_FREE, SLOT_QUEUED, SLOT_BUSY, SLOT_DONE };
+
+struct ver_pool {
+    const ver_options* options;
+
+    ver_chunk*  slots;
+    slot_state* states;
+    long        nslots;
+
+    long next_read;  // next sequence number to be read
+    long next_work;  // next sequence number to be taken by a worker
+    long next_write; // next sequence number to be written
+    int  reading_done;
+    int  stop;       // writer reached the end of the input or failed
+    int  error;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond_work;  // a chunk was queued or the pool is stopping
+    pthread_cond_t  cond_done;  // a chunk was processed
+    pthread_cond_t  cond_free;  // a slot was released
+};
+
+static void* worker_thread(void* t_arg) {
+    ver_pool* l_pool = (ver_pool*)t_arg;
+
+    pthread_mutex_lock(&l_pool->lock);
+    while (true) {
+        while (!l_pool->stop && l_pool->next_work == l_pool->next_read && !l_pool->reading_done)
+            pthread_cond_wait(&l_pool->cond_work, &l_pool->lock);
+
+        if (l_pool->stop || l_pool->next_work == l_pool->next_read)
+            break;
+
+        long l_slot = l_pool->next_work++ % l_pool->nslots;
+        l_pool->states[l_slot] = SLOT_BUSY;
+
+        pthread_mutex_unlock(&l_pool->lock);
+        process_chunk(&l_pool->slots[l_slot], l_pool->options);
+        pthread_mutex_lock(&l_pool->lock);
+
+        l_pool->states[l_slot] = SLOT_DONE;
+        pthread_cond_broadcast(&l_pool->cond_done);
+    }
+    pthread_mutex_unlock(&l_pool->lock);
+
+    return nullptr;
+}
+
+static void* writer_thread(void* t_arg) {
+    ver_pool* l_pool = (ver_pool*)t_arg;
+
+    pthread_mutex_lock(&l_pool->lock);
+    while (true) {
+        long l_slot = l_pool->next_write % l_pool->nslots;
+        while (!(l_pool->next_write < l_pool->next_read && l_pool->states[l_slot] == SLOT_DONE)
+               && !(l_pool->reading_done && l_pool->next_write == l_pool->next_read))
+            pthread_cond_wait(&l_pool->cond_done, &l_pool->lock);
+
+        if (l_pool->next_write == l_pool->next_read)
+            break; // all input written
+
+        pthread_mutex_unlock(&l_pool->lock);
+        ver_chunk* l_chunk = &l_pool->slots[l_slot];
+        int l_failed = bin_write_all(STDOUT_FILENO, l_chunk->out.data, l_chunk->out.len) != 0;
+        pthread_mutex_lock(&l_pool->lock);
+
+        l_pool->next_write++;
+        l_pool->states[l_slot] = SLOT_FREE;
+        pthread_cond_broadcast(&l_pool->cond_free);
+
+        if (l_failed || l_chunk->stop) {
+            l_pool->error = l_failed;
+            break;
+        }
+    }
+
+    l_pool->stop = 1;
+    pthread_cond_broadcast(&l_pool->cond_work);
+    pthread_cond_broadcast(&l_pool->cond_free);
+    pthread_mutex_unlock(&l_pool->lock);
+
+    return nullptr;
+}
+
+static int run_parallel(chunk_reader* t_reader, const ver_options* t_options) {
+    ver_pool l_pool;
+    memset(&l_pool, 0, sizeof(l_pool));
+    l_pool.options = t_options;
+    l_pool.nslots = 2 * t_options->threads + 2;
+    l_pool.slots = (ver_chunk*)calloc(l_pool.nslots, sizeof(ver_chunk));
+    l_pool.states = (slot_state*)calloc(l_pool.nslots, sizeof(slot_state));
+    pthread_mutex_init(&l_pool.lock, nullptr);
+    pthread_cond_init(&l_pool.cond_work, nullptr);
+    pthread_cond_init(&l_pool.cond_done, nullptr);
+    pthread_cond_init(&l_pool.cond_free, nullptr);
+
+    pthread_t* l_workers = (pthread_t*)calloc(t_options->threads, sizeof(pthread_t));
+    for (int i = 0; i < t_options->threads; i++)
+        pthread_create(&l_workers[i], nullptr, worker_thread, &l_pool);
+
+    pthread_t l_writer;
+    pthread_create(&l_writer, nullptr, writer_thread, &l_pool);
+
+    // reader
+    pthread_mutex_lock(&l_pool.lock);
+    while (!l_pool.stop) {
+        long l_slot = l_pool.next_read % l_pool.nslots;
+        while (!l_pool.stop && l_pool.states[l_slot] != SLOT_FREE)
+            pthread_cond_wait(&l_pool.cond_free, &l_pool.lock);
+        if (l_pool.stop)
+            break;
+
+        pthread_mutex_unlock(&l_pool.lock);
+        ver_chunk* l_chunk = &l_pool.slots[l_slot];
+        int l_more = read_chunk(t_reader, l_chunk, t_options);
+        pthread_mutex_lock(&l_pool.lock);
+
+        if (!l_more)
+            break;
+
+        l_chunk->seq = l_pool.next_read++;
+        l_pool.states[l_slot] = SLOT_QUEUED;
+        pthread_cond_signal(&l_pool.cond_work);
+    }
+    l_pool.reading_done = 1;
+    pthread_cond_broadcast(&l_pool.cond_work);
+    pthread_cond_broadcast(&l_pool.cond_done);
+    pthread_mutex_unlock(&l_pool.lock);
+
+    pthread_join(l_writer, nullptr);
+    for (int i = 0; i < t_options->threads; i++)
+        pthread_join(l_workers[i], nullptr);
+
+    for (long i = 0; i < l_pool.nslots; i++)
+        free_chunk(&l_pool.slots[i]);
+    free(l_pool.slots);
+    free(l_pool.states);
+    free(l_workers);
+    pthread_mutex_destroy(&l_pool.lock);
+    pthread_cond_destroy(&l_pool.cond_work);
+    pthread_cond_destroy(&l_pool.cond_done);
+    pthread_cond_destroy(&l_pool.cond_free);
+
+    return l_pool.error ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+int run_verification(const ver_options* t_options) {
+    chunk_reader l_reader;
+    memset(&l_reader, 0, sizeof(l_reader));
+
+    if (t_options->binary_mode && bin_stream_open(&l_reader.in, STDIN_FILENO, 0) != 0)
+        return 1;
+
+    if (t_options->framed_mode) {
+        l_reader.frame_flags = frame_read_header(&l_reader.in);
+        if (l_reader.frame_flags < 0 || write_stream_header(t_options) != 0) {
+            bin_stream_close(&l_reader.in);
+            return 1;
+        }
+    }
+
+    int l_result = 0;
+    if (t_options->threads > 1)
+        l_result = run_parallel(&l_reader, t_options);
+    else {
+        // sequential - the same chunks, verified in the calling thread
+        ver_chunk l_chunk;
+        memset(&l_chunk, 0, sizeof(l_chunk));
+
+        while (read_chunk(&l_reader, &l_chunk, t_options)) {
+            process_chunk(&l_chunk, t_options);
+            if (bin_write_all(STDOUT_FILENO, l_chunk.out.data, l_chunk.out.len) != 0) {
+                l_result = 1;
+                break;
+            }
+
+            if (l_chunk.stop)
+                break;
+        }
+
+        free_chunk(&l_chunk);
+    }
+
+    if (t_options->binary_mode)
+        bin_stream_close(&l_reader.in);
+    free(l_reader.carry);
+
+    return l_result || l_reader.error;
+}
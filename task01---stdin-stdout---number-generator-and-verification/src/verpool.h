@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_NUMBERS (64 * 1024)  // numbers per chunk in binary mode
+#define CHUNK_TEXT    (1024 * 1024) // bytes per chunk in text mode
+
+struct ver_plugin;
+
+// verbank options shared by the sequential and the parallel path
+struct ver_options {
+    int valid_only;  // -v flag
+    int binary_mode; // -b flag
+    int framed_mode; // -z flag; framed binary format, implies binary_mode
+    int threads;     // -j N; 0 or 1 verifies in the calling thread
+
+    int  range_mode; // --range S N
+    long range_start;
+    long range_count;
+
+    const char* map_file; // -m file; binary input mapped instead of read
+
+    unsigned rules;       // --rules list; RULE_ mask, 0 uses the linked libvercore
+
+    const ver_plugin* plugins; // --plugin path.so, repeatable; chained instead of libvercore
+    int plugin_count;
+
+    int    stats;          // --stats[=interval]
+    double stats_interval; // seconds between reports; 0 reports at the end only
+    const char* stats_file; // --stats-file path; stderr if not set
+};
+
+// growable output buffer of a chunk
+struct out_buffer {
+    char*  data;
+    size_t len;
+    size_t capacity;
+};
+
+// unit of work; input is verified into a self-contained piece of output so
+// chunks can be processed in any order and written in input order
+struct ver_chunk {
+    long     seq;
+
+    char*    text;     // text mode input; whole tokens only, NUL terminated
+    size_t   text_len;
+    size_t   text_capacity;
+
+    long*    numbers;  // binary mode input; parsed numbers in text mode
+    const long* view;  // input verified in place instead of numbers (-m mode)
+    uint8_t* valid;
+    size_t   count;
+    size_t   numbers_capacity;
+
+    out_buffer out;
+    int      stop;     // text mode: input ended with a non-number inside this chunk
+};
+
+// output formatting of one verified number
+void write_binary_result(out_buffer* out, long account_number, int is_valid, int valid_only);
+void write_text_result(out_buffer* out, long account_number, int is_valid, int valid_only);
+
+// verify a chunk into its output buffer; process_chunk() parses text input
+// first and replaces the output, verify_chunk() takes the numbers as they are
+// and appends to it
+void process_chunk(ver_chunk* t_chunk, const ver_options* t_options);
+void verify_chunk(ver_chunk* t_chunk, const ver_options* t_options);
+void free_chunk(ver_chunk* t_chunk);
+void chunk_reserve_numbers(ver_chunk* t_chunk, size_t t_count);
+
+// header of a -z output stream; returns 0 on success (or without -z)
+int write_stream_header(const ver_options* t_options);
+
+// read stdin, verify and write stdout; returns process exit code
+int run_verification(const ver_options* t_options);
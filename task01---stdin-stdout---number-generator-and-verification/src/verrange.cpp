@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+
+#include "vercore.h"
+#include "binstream.h"
+#include "verpool.h"
+#include "verrange.h"
+#include "verrules.h"
+
+// ----------------------------------------------------------------------------
+// range enumeration of CNB valid account numbers
+//
+// the CNB weights are 2^i mod 11 and digit 0 has weight 1, so within one
+// decade (numbers sharing digits 1-9) exactly the number whose last digit is
+// -(weighted sum of digits 1-9) mod 11 is valid - or none if that is 10.
+// the walker keeps digits 1-9 and their weighted sum mod 11 and moves from
+// decade to decade with an amortized O(1) carry update, so only about one in
+// eleven numbers is ever produced and nothing is divided per number
+// ----------------------------------------------------------------------------
+
+static const int k_weights[10] = { 1, 2, 4, 8, 5, 10, 9, 7, 3, 6 };
+
+struct decade_walker {
+    long decade;    // number / 10
+    int  digit[10]; // digits 1-9 of the low 10 digits; [0] unused
+    int  sum;       // weighted sum of digits 1-9, mod 11
+};
+
+static inline int add_mod11(int t_sum, int t_value) {
+    t_sum += t_value;
+    return t_sum >= 11 ? t_sum - 11 : t_sum;
+}
+
+static void walker_init(decade_walker* t_walker, long t_decade) {
+    t_walker->decade = t_decade;
+    t_walker->sum = 0;
+
+    long l_rest = t_decade;
+    for (int i = 1; i < 10; i++) {
+        t_walker->digit[i] = (int)(l_rest % 10);
+        t_walker->sum = (t_walker->sum + t_walker->digit[i] * k_weights[i]) % 11;
+        l_rest /= 10;
+    }
+}
+
+static inline void walker_next(decade_walker* t_walker) {
+    t_walker->decade++;
+
+    // a digit wrapping 9 -> 0 changes the sum by -9w, which is +2w mod 11;
+    // a carry out of digit 9 leaves the low 10 digits, so it only wraps
+    for (int i = 1; i < 10; i++) {
+        if (t_walker->digit[i] < 9) {
+            t_walker->digit[i]++;
+            t_walker->sum = add_mod11(t_walker->sum, k_weights[i]);
+            return;
+        }
+
+        t_walker->digit[i] = 0;
+        t_walker->sum = add_mod11(t_walker->sum, (2 * k_weights[i]) % 11);
+    }
+}
+
+// last digit that makes the decade's number valid; 10 means none does
+static inline int walker_check_digit(const decade_walker* t_walker) {
+    return t_walker->sum ? 11 - t_walker->sum : 0;
+}
+
+int run_range(const ver_options* t_options) {
+    long l_start = t_options->range_start;
+
+    if (l_start < 0 || t_options->range_count <= 0 || t_options->range_count > LONG_MAX - l_start) {
+        fprintf(stderr, "error: range must be non-negative and count positive\n");
+        return 1;
+    }
+    long l_end = l_start + t_options->range_count; // exclusive
+
+    // with the CNB rule among the built-in rules nothing outside the walk can
+    // be valid; the linked libvercore or a plugin may accept other numbers, so
+    // they get every number of the range. either way the candidates go through
+    // the active verifier, so the output is exactly 'gennum S N | verbank -v'
+    int l_walk = (t_options->rules & RULE_ACCOUNT) != 0;
+
+    ver_options l_options = *t_options;
+    l_options.valid_only = 1;
+
+    if (write_stream_header(&l_options) != 0)
+        return 1;
+
+    ver_chunk l_chunk;
+    memset(&l_chunk, 0, sizeof(l_chunk));
+    chunk_reserve_numbers(&l_chunk, CHUNK_NUMBERS);
+
+    decade_walker l_walker;
+    walker_init(&l_walker, l_start / 10);
+
+    int l_result = 0;
+    long l_next = l_start;
+    long l_last_decade = (l_end - 1) / 10;
+    while (l_walk ? l_walker.decade <= l_last_decade : l_next < l_end) {
+        // fill one chunk with candidates
+        l_chunk.count = 0;
+        while (l_chunk.count < CHUNK_NUMBERS && l_walk && l_walker.decade <= l_last_decade) {
+            int l_digit = walker_check_digit(&l_walker);
+            long l_base = l_walker.decade * 10; // below l_end, so is l_end - l_base
+
+            if (l_digit <= 9 && l_digit < l_end - l_base && l_base + l_digit >= l_start)
+                l_chunk.numbers[l_chunk.count++] = l_base + l_digit;
+
+            walker_next(&l_walker);
+        }
+        while (l_chunk.count < CHUNK_NUMBERS && !l_walk && l_next < l_end)
+            l_chunk.numbers[l_chunk.count++] = l_next++;
+
+        l_chunk.out.len = 0;
+        verify_chunk(&l_chunk, &l_options);
+        if (bin_write_all(STDOUT_FILENO, l_chunk.out.data, l_chunk.out.len) != 0) {
+            l_result = 1;
+            break;
+        }
+    }
+
+    free_chunk(&l_chunk);
+
+    return l_result;
+}
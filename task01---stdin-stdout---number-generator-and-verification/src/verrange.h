@@ -0,0 +1,8 @@
+#pragma once
+
+#include "verpool.h"
+
+// --range S N; write the valid numbers of [S, S + N); with the CNB rule
+// (--rules account,...) without enumerating the invalid ones, otherwise every
+// number goes through libvercore or the plugins; returns process exit code
+int run_range(const ver_options* t_options);
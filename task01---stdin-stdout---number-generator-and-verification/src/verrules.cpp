@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "verrules.h"
+#include "piddates.h"
+
+#define REORDER_INTERVAL 4096    // numbers between rule order updates
+#define STATS_DECAY      (1 << 20) // halve the counters past this many tests so the order follows drift
+
+// ----------------------------------------------------------------------------
+// rules
+
+// weights for CNB control algorithm
+static const int k_cnb_weights[10] = { 1, 2, 4, 8, 5, 10, 9, 7, 3, 6 };
+
+static int check_account(long t_number) {
+    unsigned long u = t_number < 0 ? -(unsigned long)t_number : (unsigned long)t_number;
+    u %= 10000000000UL;
+
+    // two 5-digit halves keep the divisions in 32 bits
+    unsigned l_lo = (unsigned)(u % 100000);
+    unsigned l_hi = (unsigned)(u / 100000);
+    int sum = 0;
+    for (int i = 0; i < 5; i++) {
+        sum += (l_lo % 10) * k_cnb_weights[i] + (l_hi % 10) * k_cnb_weights[i + 5];
+        l_lo /= 10;
+        l_hi /= 10;
+    }
+
+    // account is valid if sum is divisible by 11
+    return (sum % 11) == 0;
+}
+
+static int check_pid_date(long t_number) {
+    // PID must have 9 or 10 digits
+    if (t_number < 100000000L || t_number > 9999999999L)
+        return 0;
+
+    // YYMMDDXXXX; only the MMDD digits
+    return g_pid_dates.valid[pid_mmdd(t_number)];
+}
+
+static int check_mod11(long t_number) {
+    // only 10-digit numbers (PIDs issued after 1.1.1954) must be divisible by 11
+    if (t_number < 1000000000L || t_number > 9999999999L)
+        return 1;
+
+    return t_number % 11 == 0;
+}
+
+// why check_pid_date() rejected a number
+static unsigned pid_date_reason(long t_number) {
+    if (t_number < 100000000L || t_number > 9999999999L)
+        return REASON_PID_LENGTH;
+
+    const int month_offsets[] = { 0, 20, 50 };
+    int l_month = pid_mmdd(t_number) / 100;
+    for (int offset : month_offsets)
+        if (l_month >= offset + 1 && l_month <= offset + 12)
+            return REASON_PID_DAY; // the month is fine, so the table rejected the day
+
+    return REASON_PID_MONTH;
+}
+
+int check_rule(unsigned t_rule, long t_number) {
+    switch (t_rule) {
+    case RULE_ACCOUNT:  return check_account(t_number);
+    case RULE_PID_DATE: return check_pid_date(t_number);
+    case RULE_MOD11:    return check_mod11(t_number);
+    }
+
+    return 1;
+}
+
+// REASON_ bit of a number the rule t_rule rejected
+static unsigned reject_reason(unsigned t_rule, long t_number) {
+    switch (t_rule) {
+    case RULE_ACCOUNT:  return REASON_CNB;
+    case RULE_PID_DATE: return pid_date_reason(t_number);
+    case RULE_MOD11:    return REASON_MOD11;
+    }
+
+    return 0;
+}
+
+const char* reason_name(unsigned t_reason) {
+    switch (t_reason) {
+    case REASON_CNB:        return "cnb";
+    case REASON_PID_LENGTH: return "pid-length";
+    case REASON_PID_MONTH:  return "pid-month";
+    case REASON_PID_DAY:    return "pid-day";
+    case REASON_MOD11:      return "mod11";
+    }
+
+    return "?";
+}
+
+unsigned parse_rules(const char* t_list) {
+    static const struct { const char* name; unsigned rules; } k_names[] = {
+        { "account",  RULE_ACCOUNT  },
+        { "pid",      RULE_PID      },
+        { "pid-date", RULE_PID_DATE },
+        { "mod11",    RULE_MOD11    },
+    };
+
+    unsigned l_rules = 0;
+    const char* l_ptr = t_list;
+    while (*l_ptr) {
+        size_t l_len = strcspn(l_ptr, ",");
+
+        unsigned l_found = 0;
+        for (size_t i = 0; i < sizeof(k_names) / sizeof(k_names[0]); i++)
+            if (strlen(k_names[i].name) == l_len && strncmp(k_names[i].name, l_ptr, l_len) == 0)
+                l_found = k_names[i].rules;
+
+        if (!l_found) {
+            fprintf(stderr, "error: unknown rule '%.*s'\n", (int)l_len, l_ptr);
+            return 0;
+        }
+
+        l_rules |= l_found;
+        l_ptr += l_len;
+        if (*l_ptr == ',')
+            l_ptr++;
+    }
+
+    return l_rules;
+}
+
+// ----------------------------------------------------------------------------
+// adaptive short-circuit evaluation
+//
+// each thread counts at which rule the evaluation of every number ended, and
+// every REORDER_INTERVAL numbers folds that into how often every rule was
+// tested and rejected and re-sorts the rules so the one most likely to
+// reject runs first; a number that ended at position i was tested by the
+// rules 0..i, so one increment per number is enough
+
+struct rule_order {
+    unsigned rules;
+    int      count;
+    unsigned order[RULE_COUNT];     // RULE_ bits in evaluation order
+    uint64_t tested[RULE_COUNT];    // by order position
+    uint64_t rejected[RULE_COUNT];
+    uint32_t ended[RULE_COUNT + 1]; // since the last update; [count] = accepted
+    unsigned since_reorder;
+};
+
+static thread_local rule_order tl_order;
+
+static void prepare_order(rule_order* t_order, unsigned t_rules) {
+    if (t_order->rules == t_rules)
+        return;
+
+    // initial guess; the date table lookup rejects most random input cheaply
+    static const unsigned k_initial[RULE_COUNT] = { RULE_PID_DATE, RULE_ACCOUNT, RULE_MOD11 };
+
+    memset(t_order, 0, sizeof(*t_order));
+    t_order->rules = t_rules;
+    for (int i = 0; i < RULE_COUNT; i++)
+        if (t_rules & k_initial[i])
+            t_order->order[t_order->count++] = k_initial[i];
+}
+
+static void update_order(rule_order* t_order) {
+    uint64_t l_reached = t_order->since_reorder;
+    for (int i = 0; i < t_order->count; i++) {
+        t_order->tested[i] += l_reached;
+        t_order->rejected[i] += t_order->ended[i];
+        l_reached -= t_order->ended[i];
+    }
+    memset(t_order->ended, 0, sizeof(t_order->ended));
+    t_order->since_reorder = 0;
+
+    // insertion sort by rejection rate, descending; rates compared cross-multiplied
+    for (int i = 1; i < t_order->count; i++)
+        for (int j = i; j > 0; j--) {
+            uint64_t l_prev = t_order->rejected[j - 1] * (t_order->tested[j] + 1);
+            uint64_t l_this = t_order->rejected[j] * (t_order->tested[j - 1] + 1);
+            if (l_this <= l_prev)
+                break;
+
+            unsigned l_rule = t_order->order[j];
+            t_order->order[j] = t_order->order[j - 1];
+            t_order->order[j - 1] = l_rule;
+
+            uint64_t l_tmp = t_order->tested[j];
+            t_order->tested[j] = t_order->tested[j - 1];
+            t_order->tested[j - 1] = l_tmp;
+
+            l_tmp = t_order->rejected[j];
+            t_order->rejected[j] = t_order->rejected[j - 1];
+            t_order->rejected[j - 1] = l_tmp;
+        }
+
+    for (int i = 0; i < t_order->count; i++)
+        if (t_order->tested[i] > STATS_DECAY) {
+            t_order->tested[i] /= 2;
+            t_order->rejected[i] /= 2;
+        }
+}
+
+// order position of the rule that rejects t_number; t_order->count if all
+// of them accept it
+static inline int run_rules(const rule_order* t_order, long t_number) {
+    int i = 0;
+    while (i < t_order->count && check_rule(t_order->order[i], t_number))
+        i++;
+
+    return i;
+}
+
+int verify_number_rules(unsigned t_rules, long t_number) {
+    rule_order* l_order = &tl_order;
+    prepare_order(l_order, t_rules);
+
+    int l_end = run_rules(l_order, t_number);
+    l_order->ended[l_end]++;
+    if (++l_order->since_reorder >= REORDER_INTERVAL)
+        update_order(l_order);
+
+    return l_end == l_order->count;
+}
+
+void verify_numbers_rules(unsigned t_rules, const long* in, size_t n, uint8_t* out, uint64_t* t_reasons) {
+    rule_order* l_order = &tl_order;
+    prepare_order(l_order, t_rules);
+
+    size_t i = 0;
+    while (i < n) {
+        // up to the next order update; the order stays fixed meanwhile
+        size_t l_stop = i + (REORDER_INTERVAL - l_order->since_reorder);
+        if (l_stop > n)
+            l_stop = n;
+
+        int l_count = l_order->count;
+        uint32_t l_ended[RULE_COUNT + 1] = { 0 };
+        for (size_t j = i; j < l_stop; j++) {
+            int l_end = run_rules(l_order, in[j]);
+            l_ended[l_end]++;
+            out[j] = (uint8_t)(l_end == l_count);
+
+            // why, where the evaluation short-circuited; rejected numbers only
+            if (t_reasons && l_end < l_count)
+                t_reasons[__builtin_ctz(reject_reason(l_order->order[l_end], in[j]))]++;
+        }
+
+        for (int k = 0; k <= l_count; k++)
+            l_order->ended[k] += l_ended[k];
+        l_order->since_reorder += (unsigned)(l_stop - i);
+        i = l_stop;
+
+        if (l_order->since_reorder >= REORDER_INTERVAL)
+            update_order(l_order);
+    }
+}
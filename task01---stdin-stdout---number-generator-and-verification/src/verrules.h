@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// composable validator engine
+//
+// the selected rules run over the number, cheapest-to-reject first; each
+// rule extracts only the digits it needs. rules are bits of a mask so any
+// combination can be chosen at runtime (verbank --rules)
+
+#define RULE_ACCOUNT  0x01 // CNB weighted checksum (vercore_account)
+#define RULE_PID_DATE 0x02 // PID has 9-10 digits and a valid MMDD (vercore_pid)
+#define RULE_MOD11    0x04 // 10-digit numbers divisible by 11 (vercore_pid)
+#define RULE_PID      (RULE_PID_DATE | RULE_MOD11)
+#define RULE_COUNT    3
+
+// reasons a number fails the rules (verbank --stats); the rule that
+// rejected it first in the evaluation order
+#define REASON_CNB        0x01 // CNB weighted checksum
+#define REASON_PID_LENGTH 0x02 // not 9 or 10 digits
+#define REASON_PID_MONTH  0x04 // MM not in 1-12, 21-32 or 51-62
+#define REASON_PID_DAY    0x08 // DD not a day of that month
+#define REASON_MOD11      0x10 // 10-digit number not divisible by 11
+#define REASON_COUNT      5
+
+// single rule; t_rule is one RULE_ bit
+int check_rule(unsigned t_rule, long t_number);
+
+// "account,pid,pid-date,mod11" -> rule mask; 0 on an unknown name
+unsigned parse_rules(const char* t_list);
+
+// all rules of t_rules; the evaluation order adapts per thread to the
+// observed rejection rates. t_reasons, if not null, are REASON_COUNT
+// counters (by bit position) that get the reason of every rejected number
+int  verify_number_rules(unsigned t_rules, long t_number);
+void verify_numbers_rules(unsigned t_rules, const long* in, size_t n, uint8_t* out, uint64_t* t_reasons);
+
+// printable name of a single REASON_ bit
+const char* reason_name(unsigned t_reason);
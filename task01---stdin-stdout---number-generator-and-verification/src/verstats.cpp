@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "verrules.h"
+#include "verstats.h"
+
+#define STATS_REPORT_MAX 1024 // bytes of one report
+
+// counters of one thread; only that thread writes them
+struct stats_counters {
+    uint64_t numbers;
+    uint64_t valid;
+    uint64_t verify_ns;
+    uint64_t rejects[REASON_COUNT];
+    stats_counters* next;
+};
+
+static thread_local stats_counters* tl_counters;
+
+static struct {
+    pthread_mutex_t lock;     // guards the list and the reporter state
+    pthread_cond_t  cond;     // stop request for the reporter
+    stats_counters* head;
+    pthread_t       reporter;
+    int             running;
+    int             stop;
+    int             fd;       // --stats-file, -1 for stderr
+    int             reasons;  // --rules given, so rejection reasons are known
+    uint64_t        start_ns;
+    uint64_t        last_ns;  // previous report, for the current rate
+    uint64_t        last_numbers;
+} g_stats = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, nullptr, 0, 0, 0, -1, 0, 0, 0, 0 };
+
+uint64_t stats_now() {
+    timespec l_ts;
+    clock_gettime(CLOCK_MONOTONIC, &l_ts);
+
+    return (uint64_t)l_ts.tv_sec * 1000000000ULL + (uint64_t)l_ts.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------
+// counting
+
+// the counters of the calling thread; registered on first use and kept
+// after the thread ends so the totals stay complete
+static stats_counters* local_counters() {
+    if (tl_counters)
+        return tl_counters;
+
+    stats_counters* l_counters = (stats_counters*)calloc(1, sizeof(stats_counters));
+    if (!l_counters)
+        return nullptr;
+
+    pthread_mutex_lock(&g_stats.lock);
+    l_counters->next = g_stats.head;
+    g_stats.head = l_counters;
+    pthread_mutex_unlock(&g_stats.lock);
+
+    return tl_counters = l_counters;
+}
+
+static inline void counter_add(uint64_t* t_counter, uint64_t t_value) {
+    // single writer; relaxed so a concurrent report reads whole values
+    __atomic_store_n(t_counter, *t_counter + t_value, __ATOMIC_RELAXED);
+}
+
+void stats_chunk(const uint8_t* t_valid, size_t t_count, const uint64_t* t_reasons, uint64_t t_verify_ns) {
+    stats_counters* l_counters = local_counters();
+    if (!l_counters)
+        return;
+
+    uint64_t l_valid = 0;
+    for (size_t i = 0; i < t_count; i++)
+        l_valid += t_valid[i];
+
+    counter_add(&l_counters->numbers, t_count);
+    counter_add(&l_counters->valid, l_valid);
+    counter_add(&l_counters->verify_ns, t_verify_ns);
+    if (t_reasons)
+        for (int r = 0; r < REASON_COUNT; r++)
+            counter_add(&l_counters->rejects[r], t_reasons[r]);
+}
+
+// ----------------------------------------------------------------------------
+// reporting
+
+// sum of all threads; caller holds the lock
+static void sum_counters(stats_counters* t_total) {
+    memset(t_total, 0, sizeof(*t_total));
+
+    for (stats_counters* l_counters = g_stats.head; l_counters; l_counters = l_counters->next) {
+        t_total->numbers += __atomic_load_n(&l_counters->numbers, __ATOMIC_RELAXED);
+        t_total->valid += __atomic_load_n(&l_counters->valid, __ATOMIC_RELAXED);
+        t_total->verify_ns += __atomic_load_n(&l_counters->verify_ns, __ATOMIC_RELAXED);
+        for (int r = 0; r < REASON_COUNT; r++)
+            t_total->rejects[r] += __atomic_load_n(&l_counters->rejects[r], __ATOMIC_RELAXED);
+    }
+}
+
+// caller holds the lock
+static void report(const char* t_label) {
+    stats_counters l_total;
+    sum_counters(&l_total);
+
+    uint64_t l_now = stats_now();
+    double l_elapsed = (l_now - g_stats.start_ns) * 1e-9;
+    double l_interval = (l_now - g_stats.last_ns) * 1e-9;
+    double l_current = l_interval > 0 ? (l_total.numbers - g_stats.last_numbers) / l_interval : 0;
+    g_stats.last_ns = l_now;
+    g_stats.last_numbers = l_total.numbers;
+
+    char l_text[STATS_REPORT_MAX];
+    int l_len = snprintf(l_text, sizeof(l_text),
+                         "stats %s: %.3f s, %lu numbers, %.0f numbers/s (now %.0f), verify %.2f ns/number\n"
+                         "  valid %lu, rejected %lu%s",
+                         t_label, l_elapsed, (unsigned long)l_total.numbers, l_elapsed > 0 ? l_total.numbers / l_elapsed : 0,
+                         l_current, l_total.numbers ? (double)l_total.verify_ns / l_total.numbers : 0,
+                         (unsigned long)l_total.valid, (unsigned long)(l_total.numbers - l_total.valid), g_stats.reasons ? ":" : "");
+    for (int r = 0; g_stats.reasons && r < REASON_COUNT && l_len < (int)sizeof(l_text); r++)
+        l_len += snprintf(l_text + l_len, sizeof(l_text) - l_len, " %s %lu", reason_name(1u << r), (unsigned long)l_total.rejects[r]);
+    if (l_len < (int)sizeof(l_text) - 1)
+        l_text[l_len++] = '\n';
+    else
+        l_len = sizeof(l_text) - 1;
+
+    if (g_stats.fd < 0) {
+        fwrite(l_text, 1, l_len, stderr);
+        return;
+    }
+
+    // the file holds the latest report only, e.g. for 'watch cat /dev/shm/verbank.stats'
+    if (pwrite(g_stats.fd, l_text, l_len, 0) != l_len || ftruncate(g_stats.fd, l_len) != 0)
+        perror("error: stats file");
+}
+
+static void* reporter_thread(void* t_arg) {
+    const ver_options* l_options = (const ver_options*)t_arg;
+
+    pthread_mutex_lock(&g_stats.lock);
+    uint64_t l_next = g_stats.start_ns;
+    while (!g_stats.stop) {
+        l_next += (uint64_t)(l_options->stats_interval * 1e9);
+
+        // CLOCK_REALTIME deadline for pthread_cond_timedwait
+        timespec l_deadline;
+        clock_gettime(CLOCK_REALTIME, &l_deadline);
+        uint64_t l_now = stats_now();
+        uint64_t l_wait = l_next > l_now ? l_next - l_now : 0;
+        l_deadline.tv_sec += l_wait / 1000000000ULL;
+        l_deadline.tv_nsec += l_wait % 1000000000ULL;
+        if (l_deadline.tv_nsec >= 1000000000L) {
+            l_deadline.tv_sec++;
+            l_deadline.tv_nsec -= 1000000000L;
+        }
+
+        int l_rc = 0;
+        while (!g_stats.stop && l_rc != ETIMEDOUT)
+            l_rc = pthread_cond_timedwait(&g_stats.cond, &g_stats.lock, &l_deadline);
+
+        if (!g_stats.stop)
+            report("interval");
+    }
+    pthread_mutex_unlock(&g_stats.lock);
+
+    return nullptr;
+}
+
+int stats_start(const ver_options* t_options) {
+    if (!t_options->stats)
+        return 0;
+
+    g_stats.start_ns = g_stats.last_ns = stats_now();
+    g_stats.reasons = t_options->rules != 0;
+
+    if (t_options->stats_file) {
+        g_stats.fd = open(t_options->stats_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (g_stats.fd < 0) {
+            perror(t_options->stats_file);
+            return 1;
+        }
+    }
+
+    if (t_options->stats_interval > 0) {
+        if (pthread_create(&g_stats.reporter, nullptr, reporter_thread, (void*)t_options) != 0) {
+            fprintf(stderr, "error: cannot start the stats reporter\n");
+            return 1;
+        }
+        g_stats.running = 1;
+    }
+
+    return 0;
+}
+
+void stats_finish(const ver_options* t_options) {
+    if (!t_options->stats)
+        return;
+
+    if (g_stats.running) {
+        pthread_mutex_lock(&g_stats.lock);
+        g_stats.stop = 1;
+        pthread_cond_signal(&g_stats.cond);
+        pthread_mutex_unlock(&g_stats.lock);
+
+        pthread_join(g_stats.reporter, nullptr);
+        g_stats.running = 0;
+    }
+
+    pthread_mutex_lock(&g_stats.lock);
+    report("total");
+    while (g_stats.head) {
+        stats_counters* l_next = g_stats.head->next;
+        free(g_stats.head);
+        g_stats.head = l_next;
+    }
+    pthread_mutex_unlock(&g_stats.lock);
+
+    if (g_stats.fd >= 0) {
+        close(g_stats.fd);
+        g_stats.fd = -1;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "verpool.h"
+
+// --stats[=interval]; throughput and rejection reasons of a verbank run
+//
+// every verifying thread counts into its own counters, updated once per
+// chunk; the reporter sums them up only when it prints, so the verify loop
+// pays no shared cache line traffic
+
+// monotonic clock in ns
+uint64_t stats_now();
+
+// start the periodic reporter (if an interval is set); returns 0 on success
+int  stats_start(const ver_options* t_options);
+
+// account one verified chunk of the calling thread; t_reasons are the
+// REASON_COUNT rejection counters of the rule engine, null without --rules
+void stats_chunk(const uint8_t* t_valid, size_t t_count, const uint64_t* t_reasons, uint64_t t_verify_ns);
+
+// stop the reporter and print the final totals
+void stats_finish(const ver_options* t_options);
@@ -0,0 +1,21 @@
+#!/bin/bash
+# script for benchmarking tail: append-to-log latency over file count, append rate and engine
+
+cd "$(dirname "$0")"
+
+# build tail and tailbench
+make -s all || exit 1
+
+DURATION=${DURATION:-5}
+
+echo "+++ [bench] $DURATION s per run, one result line per run"
+for ENGINE in "-p" "" "-w 4"; do
+    for FILES in 1 16 256; do
+        for RATE in 100 1000; do
+            echo "+++ [bench] engine '${ENGINE:-inotify/epoll}', $FILES file(s), $RATE records/s per writer"
+            ./tailbench -n $FILES -t 4 -r $RATE -d $DURATION -- $ENGINE 2>/dev/null
+        done
+    done
+done
+
+echo "+++ [bench] done"
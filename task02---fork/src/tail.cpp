@@ -1,13 +1,81 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/inotify.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <fcntl.h>
 #include <string.h>
+#include <errno.h>
 #include <time.h>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <functional>
+
+#include "tailbin.h"
+#include "tailckpt.h"
+#include "tailmatch.h"
+#include "tailring.h"
+
+// inotify events that make a monitor check its file
+#define WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+#define FORWARD_CHUNK  (1 << 20) // bytes per splice/sendfile call
+#define FORWARD_WINDOW (16 << 20) // bytes of a file mapped at a time
+#define FORWARD_IOV    256        // iovecs per writev
+
+#define WATCH_NONE -1 // no inotify watch, checked every second
+
+// a monitored file; every output line about it starts with its tag,
+// "child <pid>" with a child per file, "worker <pid>:<file number>" with -w
+struct watched_file {
+    std::string path;
+    char        tag[48];
+    off_t       last_size;
+    uint64_t    fingerprint; // of the CKPT_TAIL bytes before last_size, 0 if unknown
+    dev_t       dev;     // identity of the file read so far; another inode
+    ino_t       ino;     // at the path means it was rotated
+    int         wd;      // inotify watch descriptor or WATCH_NONE
+    bool        dirty;   // queued for a check in this round
+    bool        missing; // stat failed, reported once
+    bool        replaced; // another inode at the path since the last check
+    ckpt_entry* checkpoint; // -c: persistent offset, nullptr without
+    uint32_t    id;      // position among the files, the file id in --format=bin
+};
+
+// how the monitors run, same for all of them
+struct monitor_config {
+    bool poll_mode;   // -p: wait for check commands from the parent
+    bool worker_mode; // -w: a shard of files per process
+    bool raw_mode;    // -r: stdout carries the new content only, unprefixed
+    const tail_matcher* matcher; // -e/-f: only lines with a pattern, nullptr for all
+    bool binary_log;  // --format=bin: the logger gets bin_records instead of text
+};
+
+// stream for the monitor's own messages; in raw mode stdout is for content only
+FILE* info_stream(const monitor_config* t_config) {
+    return t_config->raw_mode ? stderr : stdout;
+}
+
+// send a message line to the logger; with --format=bin as a TAILBIN_INFO record
+// about the file (TAILBIN_NO_FILE for the process) at size t_size
+void log_message(tail_ring* logger, const monitor_config* t_config, uint32_t t_file_id, off_t t_size, const char* t_msg) {
+    if (!t_config->binary_log) {
+        ring_write(logger, t_msg, strlen(t_msg));
+        return;
+    }
+
+    char record[TAILBIN_RECORD(TAILBIN_PAYLOAD)];
+    size_t len = bin_format(record, TAILBIN_INFO, t_file_id, t_size, t_size, t_msg, strcspn(t_msg, "\n"));
+    ring_write(logger, record, len);
+}
 
 // check if a file is valid for reading
 bool is_valid_file(const char* t_filepath) {
@@ -40,242 +108,808 @@ bool is_valid_file(const char* t_filepath) {
     return true;
 }
 
-// print file information (called by child process)
-void print_file_info(const char* t_filepath, off_t* last_size) {
-    struct stat file_stat;
-    
-    if (stat(t_filepath, &file_stat) != 0) {
-        fprintf(stderr, "[child] error | cannot stat file '%s'\n", t_filepath);
-        return;
+// mtime as asctime() prints it, without the newline; the last one is kept, so
+// a burst of changes within a second is formatted once
+const char* time_string(time_t t_time) {
+    static time_t cached = -1;
+    static char text[32];
+
+    if (t_time != cached) {
+        struct tm timeinfo;
+        localtime_r(&t_time, &timeinfo);
+        asctime_r(&timeinfo, text);
+        text[strcspn(text, "\n")] = 0;
+        cached = t_time;
     }
-    
-    pid_t pid = getpid();
-    printf("\n[child %d] === '%s' file info ===================\n", pid, t_filepath);
-    
+
+    return text;
+}
+
+// snprintf into t_buffer at *t_len, cut at its end
+void text_append(char* t_buffer, size_t t_size, size_t* t_len, const char* t_format, ...) {
+    if (*t_len >= t_size - 1)
+        return;
+
+    va_list args;
+    va_start(args, t_format);
+    int written = vsnprintf(t_buffer + *t_len, t_size - *t_len, t_format, args);
+    va_end(args);
+
+    if (written > 0)
+        *t_len = (*t_len + written < t_size - 1) ? *t_len + written : t_size - 1;
+}
+
+// file information block (called by child process), from the stat of the check
+void format_file_info(const watched_file* t_file, const struct stat* t_stat, char* t_buffer, size_t t_size, size_t* t_len) {
+    const char* tag = t_file->tag;
+    const char* filepath = t_file->path.c_str();
+
     // mode (permissions)
-    printf("[child %d] mode . . . . . . : %o (octal)\n", pid, file_stat.st_mode & 0777);
-    printf("[child %d] permissions. . . : ", pid);
-    printf((S_ISDIR(file_stat.st_mode))  ? "d" : "-");
-    printf((file_stat.st_mode & S_IRUSR) ? "r" : "-");
-    printf((file_stat.st_mode & S_IWUSR) ? "w" : "-");
-    printf((file_stat.st_mode & S_IXUSR) ? "x" : "-");
-    printf((file_stat.st_mode & S_IRGRP) ? "r" : "-");
-    printf((file_stat.st_mode & S_IWGRP) ? "w" : "-");
-    printf((file_stat.st_mode & S_IXGRP) ? "x" : "-");
-    printf((file_stat.st_mode & S_IROTH) ? "r" : "-");
-    printf((file_stat.st_mode & S_IWOTH) ? "w" : "-");
-    printf((file_stat.st_mode & S_IXOTH) ? "x" : "-");
-    printf("\n");
-    
-    // modification time
-    struct tm* timeinfo = localtime(&file_stat.st_mtime);
-    char time_str[80];
-
-    asctime_r(timeinfo, time_str);
-    time_str[strcspn(time_str, "\n")] = 0; // remove newline from asctime output
-    printf("[child %d] last modified. . : %s\n", pid, time_str);
-    
-    // file size
-    printf("[child %d] size . . . . . . : %ld bytes\n", pid, file_stat.st_size);
-    
-    printf("[child %d] process ID . . . : %d\n", pid, pid);
-    printf("[child %d] parent process ID: %d\n", pid, getppid());
-
-    printf("[child %d] === end of '%s' file info ============\n\n", pid, t_filepath);
-
-    // update last size
-    if (last_size) {
-        *last_size = file_stat.st_size;
+    char permissions[11];
+    const char* flags = "rwxrwxrwx";
+    permissions[0] = S_ISDIR(t_stat->st_mode) ? 'd' : '-';
+    for (int i = 0; i < 9; i++) {
+        permissions[i + 1] = (t_stat->st_mode & (0400 >> i)) ? flags[i] : '-';
     }
+    permissions[10] = '\0';
+
+    text_append(t_buffer, t_size, t_len,
+        "\n[%s] === '%s' file info ===================\n"
+        "[%s] mode . . . . . . : %o (octal)\n"
+        "[%s] permissions. . . : %s\n"
+        "[%s] last modified. . : %s\n"
+        "[%s] size . . . . . . : %ld bytes\n"
+        "[%s] process ID . . . : %d\n"
+        "[%s] parent process ID: %d\n"
+        "[%s] === end of '%s' file info ============\n\n",
+        tag, filepath,
+        tag, t_stat->st_mode & 0777,
+        tag, permissions,
+        tag, time_string(t_stat->st_mtime),
+        tag, t_stat->st_size,
+        tag, getpid(),
+        tag, getppid(),
+        tag, filepath);
 }
 
-// print file information header (called by child process)
-void print_file_header(const char* t_filepath, off_t old_size, off_t new_size) {
-    struct stat file_stat;
-    
-    if (stat(t_filepath, &file_stat) != 0) {
-        fprintf(stderr, "[child] error | cannot stat file '%s'\n", t_filepath);
-        return;
+// write all iovecs, resuming after partial writes
+bool writev_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        // skip what went out
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
     }
-    
-    pid_t pid = getpid();
-    printf("\n[child %d] === '%s' change detected ================\n", pid, t_filepath);
-    printf("[child %d] file. . . . . . : %s\n", pid, t_filepath);
-    printf("[child %d] process ID . . . : %d\n", pid, pid);
-    printf("[child %d] old size. . . . : %ld bytes\n", pid, old_size);
-    printf("[child %d] new size. . . . : %ld bytes\n", pid, new_size);
-    
-    // modification time
-    struct tm* timeinfo = localtime(&file_stat.st_mtime);
-    char time_str[80];
-    asctime_r(timeinfo, time_str);
-    time_str[strcspn(time_str, "\n")] = 0;
-    printf("[child %d] last modified. . : %s\n", pid, time_str);
-    printf("[child %d] ================================================\n\n", pid);
+
+    return true;
 }
 
-// logger child process - reads from all monitoring children and logs to file
-void logger_process(int read_fd, const char* logfile) {
+// logger child process - reads the records of all monitoring children from
+// the ring and logs them to file, a batch of records per writev; with
+// --format=bin (t_files: paths by file id) to segment files named after logfile
+void logger_process(tail_ring* ring, const char* logfile, const std::vector<std::string>* t_files) {
     pid_t pid = getpid();
-    fprintf(stderr, "[logger %d] info | logger process started, logging to '%s'\n", pid, logfile);
+    fprintf(stderr, "[logger %d] info | logger process started, logging to '%s'%s\n", pid, logfile,
+            t_files ? " (binary segments)" : "");
     
     // open log file for writing (or use tty device)
-    FILE* log_fp = fopen(logfile, "w");
-    if (!log_fp) {
+    int log_fd = -1;
+    bin_log* segments = nullptr;
+    if (t_files) {
+        segments = bin_open(logfile, *t_files);
+    } else {
+        log_fd = open(logfile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    }
+    if (log_fd < 0 && !segments) {
         fprintf(stderr, "[logger %d] error | cannot open logfile '%s'\n", pid, logfile);
-        close(read_fd);
+        ring_close(ring); // the monitors drop their records from now on
         exit(EXIT_FAILURE);
     }
     
-    char buffer[4096];
-    while (true) {
-        ssize_t bytes_read = read(read_fd, buffer, sizeof(buffer) - 1);
-        
-        if (bytes_read <= 0) {
-            // pipe closed or error
-            fprintf(stderr, "[logger %d] info | pipe closed, exiting...\n", pid);
-            break;
-        }
-        
-        buffer[bytes_read] = '\0';
-        
-        // check for 'nolog' file before each output
+    struct iovec iov[RING_IOV];
+    size_t batch_bytes;
+    int count;
+    while ((count = ring_read(ring, iov, RING_IOV, &batch_bytes)) > 0) {
+        // check for 'nolog' file once per batch
         if (access("nolog", F_OK) != 0) {
             // 'nolog' file does NOT exist, so we can write to output
-            fprintf(log_fp, "%s", buffer);
-            fflush(log_fp);
+            if (segments) {
+                bin_write(segments, iov, count);
+            } else {
+                writev_all(log_fd, iov, count);
+            }
         }
-        // if 'nolog' exists, we still read from pipe but don't write to output
+        // if 'nolog' exists, we still consume the records but don't write to output
+        
+        ring_release(ring, batch_bytes);
     }
     
-    fclose(log_fp);
-    close(read_fd);
+    fprintf(stderr, "[logger %d] info | ring closed, exiting...\n", pid);
+    if (segments) {
+        bin_close(segments);
+    } else {
+        close(log_fd);
+    }
 }
 
-// child process monitoring function
-void monitor_file(const char* t_filepath, int pipe_fd, int logger_fd) {
-    pid_t pid = getpid();
-    off_t last_size = -1; // initialize to -1 to force reading initial size
+// copy bytes [from, to) of fd to out_fd without going through user space:
+// splice into a pipe, sendfile into anything else; read/write if the kernel
+// refuses both for this pair of files
+bool forward_raw(int fd, off_t from, off_t to, int out_fd) {
+    struct stat out_stat;
+    bool to_pipe = fstat(out_fd, &out_stat) == 0 && S_ISFIFO(out_stat.st_mode);
 
-    // print initial file information
-    //print_file_info(t_filepath, &last_size);
+    off_t offset = from;
+    while (offset < to) {
+        size_t chunk = (to - offset > FORWARD_CHUNK) ? FORWARD_CHUNK : (size_t)(to - offset);
+        ssize_t sent = to_pipe ? splice(fd, &offset, out_fd, NULL, chunk, SPLICE_F_MORE)
+                               : sendfile(out_fd, fd, &offset, chunk);
+        if (sent > 0)
+            continue; // both advance offset
+        if (sent == 0)
+            return true; // file shrank under us
+        if (errno == EINTR)
+            continue;
+        if (errno != EINVAL && errno != ENOSYS)
+            return false;
 
-    // redirect stdout to logger pipe; testing purposes - FOR NOW JUST TO TEST THE PIPE IS WORKING
-    //dup2(logger_fd, STDOUT_FILENO);
-    //close(logger_fd);
-    
-    // get initial file size
-    struct stat file_stat;
-    if (stat(t_filepath, &file_stat) == 0) {
-        last_size = file_stat.st_size;
+        // plain copy for the rest
+        char buffer[65536];
+        while (offset < to) {
+            chunk = (to - offset > (off_t)sizeof(buffer)) ? sizeof(buffer) : (size_t)(to - offset);
+            ssize_t got = pread(fd, buffer, chunk, offset);
+            if (got <= 0)
+                return got == 0;
+
+            struct iovec iov = { buffer, (size_t)got };
+            if (!writev_all(out_fd, &iov, 1))
+                return false;
+            offset += got;
+        }
     }
-    
-    // print to console
-    //printf("[child %d] info | waiting for check commands...\n", pid);
-    printf("[child %d] info | monitoring file '%s' (initial size: %ld bytes)\n", 
-           pid, t_filepath, last_size);
+
+    return true;
+}
+
+// lines on their way to out_fd; the iovecs point into the current mapping
+// until flushed
+struct line_batch {
+    struct iovec iov[FORWARD_IOV];
+    int          count;
+    int          fd;
+    bool         ok;
+};
+
+void batch_flush(line_batch* batch) {
+    if (batch->ok && batch->count > 0)
+        batch->ok = writev_all(batch->fd, batch->iov, batch->count);
+    batch->count = 0;
+}
+
+void batch_add(line_batch* batch, const void* data, size_t len) {
+    if (batch->count == FORWARD_IOV)
+        batch_flush(batch);
+
+    batch->iov[batch->count].iov_base = (void*)data;
+    batch->iov[batch->count].iov_len = len;
+    batch->count++;
+}
+
+// print bytes [from, *to) of fd to out_fd, every line prefixed with "[tag] "
+// (nothing with tag nullptr); with a matcher only the lines that contain a
+// pattern. header and trailer frame the lines if there are any, in the same
+// writev as the first and the last ones. the matcher must
+// see whole lines, so an unfinished last line is left for the next check and
+// *to moved back to its start
+//
+// the range is mapped in FORWARD_WINDOW pieces cut at newlines and split with
+// memchr (vectorized in glibc); the matcher skips from match to match without
+// looking at the lines between. prefixes and lines go out straight from the
+// mapping in batches of writev, so a line of any length stays one line.
+// returns false on error, *lines is the number of lines written and
+// *fingerprint that of the bytes before *to, from the mapping where it has them
+bool forward_lines(int fd, off_t from, off_t* to, const char* tag, int out_fd,
+                   const tail_matcher* matcher, const char* header, size_t header_len,
+                   const char* trailer, size_t trailer_len, size_t* lines, uint64_t* fingerprint) {
+    char prefix[64];
+    int prefix_len = tag ? snprintf(prefix, sizeof(prefix), "[%s] ", tag) : 0;
+    long page = sysconf(_SC_PAGESIZE);
+
+    line_batch batch;
+    batch.count = 0;
+    batch.fd = out_fd;
+    batch.ok = true;
+
+    *lines = 0;
+    bool line_start = true; // only a line longer than a window continues in the next one
+    off_t hashed = -1;      // offset *fingerprint is of
+
+    off_t window = from;
+    while (batch.ok && window < *to) {
+        off_t window_end = (*to - window > FORWARD_WINDOW) ? window + FORWARD_WINDOW : *to;
+        off_t map_start = window - window % page;
+        size_t map_len = window_end - map_start;
+
+        void* map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, map_start);
+        if (map == MAP_FAILED)
+            return false;
+        madvise(map, map_len, MADV_SEQUENTIAL);
+
+        const char* ptr = (const char*)map + (window - map_start);
+        const char* end = (const char*)map + map_len;
+        if (window_end < *to || matcher) {
+            const char* last = (const char*)memrchr(ptr, '\n', end - ptr);
+            if (last) {
+                end = last + 1;
+            } else if (window_end == *to && window_end - window < FORWARD_WINDOW) {
+                // unfinished line, held back by the filter
+                munmap(map, map_len);
+                break;
+            }
+        }
+        window += end - ptr;
+
+        // the bytes before the window end, if this mapping holds them
+        if (window - map_start >= CKPT_TAIL || map_start == 0) {
+            *fingerprint = ckpt_fingerprint_data(end, window);
+            hashed = window;
+        }
+
+        while (ptr < end) {
+            const char* line = ptr;
+            if (matcher) {
+                const char* hit = matcher_find(matcher, ptr, end);
+                if (!hit)
+                    break;
+
+                const char* newline = (const char*)memrchr(ptr, '\n', hit - ptr);
+                line = newline ? newline + 1 : ptr;
+                line_start = true;
+            }
+
+            const char* newline = (const char*)memchr(line, '\n', end - line);
+            const char* line_end = newline ? newline + 1 : end;
+
+            if (header) {
+                batch_add(&batch, header, header_len);
+                header = nullptr;
+            }
+            if (line_start && prefix_len) {
+                batch_add(&batch, prefix, prefix_len);
+            }
+            batch_add(&batch, line, line_end - line);
+            (*lines)++;
+
+            line_start = (newline != NULL);
+            ptr = line_end;
+        }
+
+        if (window >= *to && trailer && *lines > 0) {
+            batch_add(&batch, trailer, trailer_len);
+            trailer = nullptr;
+        }
+
+        // before the mapping goes
+        batch_flush(&batch);
+
+        munmap(map, map_len);
+    }
+
+    // after a held back line
+    if (trailer && *lines > 0) {
+        batch_add(&batch, trailer, trailer_len);
+        batch_flush(&batch);
+    }
+
+    if (matcher && batch.ok)
+        *to = window;
+    if (hashed != *to)
+        *fingerprint = ckpt_fingerprint_fd(fd, *to);
+
+    return batch.ok;
+}
+
+// end of the last whole line in [from, to) of fd, from if there is none; the
+// filter leaves an unfinished last line for the next check, so what a change
+// reports is known before its first line goes out
+off_t whole_lines_end(int fd, off_t from, off_t to) {
+    char buffer[4096];
+    off_t end = to;
+    while (end > from) {
+        size_t chunk = (end - from > (off_t)sizeof(buffer)) ? sizeof(buffer) : (size_t)(end - from);
+        ssize_t got = pread(fd, buffer, chunk, end - chunk);
+        if (got != (ssize_t)chunk)
+            return from;
+
+        const char* newline = (const char*)memrchr(buffer, '\n', chunk);
+        if (newline)
+            return end - chunk + (newline - buffer) + 1;
+        end -= chunk;
+    }
+
+    return from;
+}
+
+// forward the bytes of fd appended since the last check, up to *t_end, to
+// stdout, see forward_lines; *t_fingerprint becomes that of the new end.
+// returns whether anything was forwarded
+bool forward_content(const watched_file* t_file, int fd, off_t* t_end, bool raw, const tail_matcher* matcher,
+                     const char* header, size_t header_len, const char* trailer, size_t trailer_len,
+                     uint64_t* t_fingerprint) {
+    // previous end position (or start if first check); a file truncated since
+    // the stat must not be mapped past its end (SIGBUS)
+    off_t from = (t_file->last_size > 0) ? t_file->last_size : 0;
+    off_t new_size = *t_end;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size < new_size)
+        new_size = file_stat.st_size;
+
+    // stdio output so far goes first
     fflush(stdout);
-    
-    // also send to logger
-    char log_msg[512];
-    snprintf(log_msg, sizeof(log_msg), 
-             "[child %d] info | monitoring file '%s' (initial size: %ld bytes)\n", 
-             pid, t_filepath, last_size);
-    write(logger_fd, log_msg, strlen(log_msg));
-    
-    char buffer[256];
-    
-    // monitor loop - wait for "check\n" commands from parent
-    while (true) {
-        ssize_t bytes_read = read(pipe_fd, buffer, sizeof(buffer) - 1);
-        
-        if (bytes_read <= 0) {
-            // pipe closed or error
-            printf("[child %d] info | pipe closed, exiting...\n", pid);
-            fflush(stdout);
-            
-            char log_msg[256];
-            snprintf(log_msg, sizeof(log_msg), "[child %d] info | pipe closed, exiting...\n", pid);
-            write(logger_fd, log_msg, strlen(log_msg));
-            break;
+    size_t lines = 1;
+    bool ok;
+    if (raw && !matcher) {
+        ok = forward_raw(fd, from, new_size, STDOUT_FILENO);
+        *t_fingerprint = ckpt_fingerprint_fd(fd, new_size);
+    } else {
+        ok = forward_lines(fd, from, &new_size, raw ? nullptr : t_file->tag, STDOUT_FILENO,
+                           matcher, header, header_len, trailer, trailer_len, &lines, t_fingerprint);
+    }
+    if (matcher)
+        *t_end = new_size;
+    if (!ok)
+        fprintf(stderr, "[%s] error | cannot forward new content of '%s'\n", t_file->tag, t_file->path.c_str());
+
+    return ok && lines > 0;
+}
+
+// check the file once; print and log the new content if it has grown
+void check_file(watched_file* t_file, tail_ring* logger, const monitor_config* t_config) {
+    const char* tag = t_file->tag;
+    const char* filepath = t_file->path.c_str();
+    struct stat file_stat;
+
+    if (stat(filepath, &file_stat) != 0) {
+        // a rotated file may take a while to reappear; say it once
+        if (!t_file->missing) {
+            fprintf(stderr, "[%s] error | cannot stat file '%s'\n", tag, filepath);
         }
-        
-        buffer[bytes_read] = '\0';
-        
-        // check if we received "check\n"
-        if (strstr(buffer, "check\n") != NULL) {
+        t_file->missing = true;
+        return;
+    }
+    t_file->missing = false;
+
+    // the same file at least as long; truncated and written past the old end
+    // since the last check (copytruncate) if the bytes before it changed
+    int fd = -1;
+    bool same_file = (file_stat.st_ino == t_file->ino && file_stat.st_dev == t_file->dev);
+    if (same_file && file_stat.st_size >= t_file->last_size && t_file->last_size > 0 && t_file->fingerprint) {
+        fd = open(filepath, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 && ckpt_fingerprint_fd(fd, t_file->last_size) != t_file->fingerprint) {
+            fprintf(info_stream(t_config), "[%s] info | file '%s' was truncated and rewritten (%ld bytes now), reading from offset 0\n",
+                    tag, filepath, file_stat.st_size);
+            t_file->last_size = 0;
+            t_file->fingerprint = 0;
+        }
+    }
+
+    // another file at the path (rotation) or a shorter one (truncation) is
+    // followed from its start
+    if (t_file->ino != 0 && !same_file) {
+        fprintf(info_stream(t_config), "[%s] info | file '%s' was replaced (rotated), reading the new file from offset 0\n",
+                tag, filepath);
+        t_file->last_size = 0;
+        t_file->fingerprint = 0;
+    } else if (file_stat.st_size < t_file->last_size) {
+        fprintf(info_stream(t_config), "[%s] info | file '%s' was truncated from %ld to %ld bytes, reading from offset 0\n",
+                tag, filepath, t_file->last_size, file_stat.st_size);
+        t_file->last_size = 0;
+        t_file->fingerprint = 0;
+    }
+    if (!same_file) {
+        t_file->replaced = (t_file->ino != 0);
+        t_file->dev = file_stat.st_dev;
+        t_file->ino = file_stat.st_ino;
+        if (t_file->checkpoint) {
+            ckpt_store(t_file->checkpoint, t_file->dev, t_file->ino, t_file->last_size, t_file->fingerprint);
+        }
+    }
+
+    // check if file has grown
+    if (file_stat.st_size > t_file->last_size && fd < 0) {
+        fd = open(filepath, O_RDONLY | O_CLOEXEC);
+    }
+    if (file_stat.st_size > t_file->last_size && fd < 0) {
+        fprintf(stderr, "[%s] error | cannot open file '%s'\n", tag, filepath);
+    } else if (file_stat.st_size > t_file->last_size) {
+        bool forwarded = true;
+        uint64_t fingerprint = t_file->fingerprint;
+        off_t old_size = t_file->last_size;
+        off_t end = file_stat.st_size;
+
+        // the filter stops at the last whole line
+        if (t_config->matcher) {
+            end = whole_lines_end(fd, old_size, file_stat.st_size);
+        }
+
+        if (end == old_size) {
+            // only part of a line so far
+            forwarded = false;
+        } else if (t_config->raw_mode) {
+            // new content only, as fast as the kernel moves it
+            forwarded = forward_content(t_file, fd, &end, true, t_config->matcher, nullptr, 0, nullptr, 0, &fingerprint);
+        } else {
+            // console text around the content, from this stat up to the end
+            // of the forwarded lines; it goes out in one writev with them.
+            // filtered, a change without a matching line is not reported at all
+            char head[4096];
+            size_t head_len = 0;
+            text_append(head, sizeof(head), &head_len,
+                "[%s] info | file '%s' has grown from %ld to %ld bytes\n"
+                "\n[%s] === '%s' new content: ================\n",
+                tag, filepath, old_size, end, tag, filepath);
+
+            char tail[4096];
+            size_t tail_len = 0;
+            text_append(tail, sizeof(tail), &tail_len, "[%s] === end of '%s' new content ==========\n", tag, filepath);
+            format_file_info(t_file, &file_stat, tail, sizeof(tail), &tail_len);
+
+            forwarded = forward_content(t_file, fd, &end, false, t_config->matcher, head, head_len, tail, tail_len,
+                                        &fingerprint);
+        }
+
+        // send header to logger, unless the filter dropped the whole change
+        if (forwarded && t_config->binary_log) {
+            char record[TAILBIN_RECORD(0)];
+            size_t len = bin_format(record, TAILBIN_CHANGE, t_file->id, old_size, end, "", 0);
+            ring_write(logger, record, len);
+        } else if (forwarded) {
+            char log_buffer[2048];
+            size_t log_len = 0;
+            text_append(log_buffer, sizeof(log_buffer), &log_len,
+                "\n[%s] === '%s' change detected ================\n"
+                "[%s] file. . . . . . : %s\n"
+                "[%s] process ID . . . : %d\n"
+                "[%s] old size. . . . : %ld bytes\n"
+                "[%s] new size. . . . : %ld bytes\n"
+                "[%s] last modified. . : %s\n"
+                "[%s] ================================================\n\n",
+                tag, filepath,
+                tag, filepath,
+                tag, getpid(),
+                tag, old_size,
+                tag, end,
+                tag, time_string(file_stat.st_mtime),
+                tag);
+
+            ring_write(logger, log_buffer, log_len);
+        }
+
+        // update last size
+        t_file->last_size = end;
+        t_file->fingerprint = fingerprint;
+        if (t_file->checkpoint) {
+            ckpt_store(t_file->checkpoint, t_file->dev, t_file->ino, t_file->last_size, t_file->fingerprint);
+        }
+    } else if (!t_config->worker_mode) {
+        fprintf(info_stream(t_config), "[%s] info | no changes in file '%s'\n", tag, filepath);
+        fflush(stdout);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+// point the watch of files[index] at whatever is at its path now
+void rewatch_file(int inotify_fd, std::unordered_map<int, size_t>& watches, std::vector<watched_file>& files,
+                  size_t index, size_t* unwatched) {
+    watched_file* file = &files[index];
+
+    if (file->wd >= 0) {
+        inotify_rm_watch(inotify_fd, file->wd);
+        watches.erase(file->wd);
+        file->wd = WATCH_NONE;
+        (*unwatched)++;
+    }
+
+    int wd = inotify_add_watch(inotify_fd, file->path.c_str(), WATCH_EVENTS);
+    if (wd >= 0) {
+        file->wd = wd;
+        watches[wd] = index;
+        (*unwatched)--;
+    }
+    file->replaced = false;
+}
+
+// monitor loop of a child (one file) or a worker (a shard of files)
+//
+// the pipe from the parent carries "check\n" commands (polling mode, -p) and
+// closes on shutdown. without -p all files are watched by one inotify instance,
+// so a change is noticed as soon as it is written and an idle file costs
+// nothing; events that arrive together are handled by a single check per file.
+// files that cannot be watched are checked once a second, which is also how a
+// moved or removed file is picked up again when a new one appears at the path.
+// a worker reports only changes, one 'no changes' line per file and check
+// would not scale
+void watch_loop(std::vector<watched_file>& files, int pipe_fd, tail_ring* logger, const monitor_config* t_config) {
+    pid_t pid = getpid();
+    bool poll_mode = t_config->poll_mode;
+    FILE* info = info_stream(t_config);
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        fprintf(stderr, "[%d] error | epoll_create1 failed\n", pid);
+        return;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = pipe_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fd, &event);
+
+    // watch descriptor -> file
+    std::unordered_map<int, size_t> watches;
+    size_t unwatched = 0;
+
+    int inotify_fd = -1;
+    if (!poll_mode) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd >= 0) {
+            event.data.fd = inotify_fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, inotify_fd, &event);
+        }
+
+        for (size_t i = 0; i < files.size(); i++) {
+            if (inotify_fd >= 0)
+                files[i].wd = inotify_add_watch(inotify_fd, files[i].path.c_str(), WATCH_EVENTS);
+
+            if (files[i].wd >= 0) {
+                watches[files[i].wd] = i;
+            } else {
+                fprintf(stderr, "[%s] error | cannot watch file '%s', checking every second\n",
+                        files[i].tag, files[i].path.c_str());
+                files[i].wd = WATCH_NONE;
+                unwatched++;
+            }
+        }
+
+        // a write between the initial stat and the watch would go unnoticed
+        for (size_t i = 0; i < files.size(); i++) {
             struct stat file_stat;
+            if (files[i].wd >= 0 && stat(files[i].path.c_str(), &file_stat) == 0 && file_stat.st_size > files[i].last_size)
+                check_file(&files[i], logger, t_config);
+        }
+    }
+
+    std::vector<size_t> dirty; // files with events in this round
+    std::vector<size_t> moved; // watched files no longer at their path
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool running = true;
+    while (running) {
+        // unwatched files (without -p) are polled by the monitor itself
+        int timeout = (!poll_mode && unwatched > 0) ? 1000 : -1;
+
+        struct epoll_event events[2];
+        int count = epoll_wait(epoll_fd, events, 2, timeout);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        bool check_all = false;
+        bool check_unwatched = (count == 0); // own polling tick
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == pipe_fd) {
+                ssize_t bytes_read = read(pipe_fd, buffer, sizeof(buffer) - 1);
+                if (bytes_read <= 0) {
+                    // pipe closed or error
+                    running = false;
+                    break;
+                }
+
+                buffer[bytes_read] = '\0';
 
-            if (stat(t_filepath, &file_stat) != 0) {
-                fprintf(stderr, "[child %d] error | cannot stat file '%s'\n", pid, t_filepath);
+                // check if we received "check\n"
+                if (strstr(buffer, "check\n") != NULL)
+                    check_all = true;
                 continue;
             }
-            
-            // check if file has grown
-            if (file_stat.st_size > last_size) {
-                // print to console
-                printf("[child %d] info | file '%s' has grown from %ld to %ld bytes\n",
-                    pid, t_filepath, last_size, file_stat.st_size);
-                fflush(stdout);
-                
-                // read and display new content
-                FILE* fp = fopen(t_filepath, "r");
-                if (fp) {
-                    // seek to previous end position (or start if first check)
-                    off_t seek_pos = (last_size > 0) ? last_size : 0;
-                    fseek(fp, seek_pos, SEEK_SET);
-                    
-                    printf("\n[child %d] === '%s' new content: ================\n", pid, t_filepath);
-                    char line[1024];
-                    while (fgets(line, sizeof(line), fp)) {
-                        printf("[child %d] %s", pid, line);
+
+            // drain the inotify queue; any event means the file is worth a look
+            ssize_t len;
+            while ((len = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + len; ) {
+                    struct inotify_event* ev = (struct inotify_event*)ptr;
+                    ptr += sizeof(struct inotify_event) + ev->len;
+
+                    std::unordered_map<int, size_t>::iterator found = watches.find(ev->wd);
+                    if (found == watches.end())
+                        continue;
+
+                    // the watch follows the inode; the path is what we monitor, so
+                    // a moved or removed file is polled until the path comes back
+                    watched_file* file = &files[found->second];
+                    if (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) {
+                        fprintf(info, "[%s] info | file '%s' was %s, waiting for a file at the path\n",
+                                file->tag, file->path.c_str(), (ev->mask & IN_MOVE_SELF) ? "moved" : "removed");
+                        if (!(ev->mask & IN_IGNORED))
+                            inotify_rm_watch(inotify_fd, ev->wd);
+                        watches.erase(found);
+                        file->wd = WATCH_NONE;
+                        unwatched++;
+                        continue;
                     }
-                    printf("[child %d] === end of '%s' new content ==========\n", pid, t_filepath);
 
-                    fclose(fp);
+                    if (!file->dirty) {
+                        file->dirty = true;
+                        dirty.push_back(found->second);
+                    }
                 }
-                
-                // print updated file information
-                print_file_info(t_filepath, &last_size);
-                
-                // send header to logger
-                char log_buffer[2048];
-                int offset = 0;
-                
-                // format header for logger
-                struct tm* timeinfo = localtime(&file_stat.st_mtime);
-                char time_str[80];
-                asctime_r(timeinfo, time_str);
-                time_str[strcspn(time_str, "\n")] = 0;
-                
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "\n[child %d] === '%s' change detected ================\n", pid, t_filepath);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] file. . . . . . : %s\n", pid, t_filepath);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] process ID . . . : %d\n", pid, pid);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] old size. . . . : %ld bytes\n", pid, last_size);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] new size. . . . : %ld bytes\n", pid, file_stat.st_size);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] last modified. . : %s\n", pid, time_str);
-                offset += snprintf(log_buffer + offset, sizeof(log_buffer) - offset,
-                    "[child %d] ================================================\n\n", pid);
-                
-                write(logger_fd, log_buffer, offset);
-                
-                // update last size
-                last_size = file_stat.st_size;
-            } else {
-                printf("[child %d] info | no changes in file '%s'\n", pid, t_filepath);
                 fflush(stdout);
             }
         }
+
+        if (!running)
+            break;
+
+        if (check_all) {
+            for (size_t i = 0; i < files.size(); i++) {
+                check_file(&files[i], logger, t_config);
+                if (files[i].wd >= 0 && (files[i].replaced || files[i].missing))
+                    moved.push_back(i);
+            }
+        } else if (check_unwatched) {
+            for (size_t i = 0; i < files.size(); i++) {
+                if (files[i].wd != WATCH_NONE)
+                    continue;
+
+                // watch again if the path is back; the check then catches up
+                if (inotify_fd >= 0)
+                    rewatch_file(inotify_fd, watches, files, i, &unwatched);
+                check_file(&files[i], logger, t_config);
+                files[i].replaced = false;
+            }
+        }
+
+        for (size_t i = 0; i < dirty.size(); i++) {
+            watched_file* file = &files[dirty[i]];
+            file->dirty = false;
+            if (!check_all && file->wd >= 0) {
+                check_file(file, logger, t_config);
+                if (file->replaced || file->missing)
+                    moved.push_back(dirty[i]);
+            }
+        }
+        dirty.clear();
+
+        // a watch on an inode that is no longer at the path (renamed over,
+        // or unlinked while still open) moves to the path, then catches up
+        for (size_t i = 0; i < moved.size(); i++) {
+            watched_file* file = &files[moved[i]];
+            bool replaced = file->replaced;
+
+            rewatch_file(inotify_fd, watches, files, moved[i], &unwatched);
+            if (replaced && file->wd >= 0)
+                check_file(file, logger, t_config);
+        }
+        moved.clear();
+        fflush(stdout);
     }
-    
+
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+    close(epoll_fd);
+}
+
+// child or worker process monitoring function
+void monitor_files(std::vector<watched_file>& files, int pipe_fd, tail_ring* logger, const monitor_config* t_config) {
+    pid_t pid = getpid();
+    FILE* info = info_stream(t_config);
+    char log_msg[512];
+
+    // file info goes out with each change, see check_file
+
+    // redirect stdout to logger pipe; testing purposes - FOR NOW JUST TO TEST THE PIPE IS WORKING
+    //dup2(logger_fd, STDOUT_FILENO);
+    //close(logger_fd);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        watched_file* file = &files[i];
+        file->last_size = -1; // initialize to -1 to force reading initial size
+        file->fingerprint = 0;
+
+        // get initial file size
+        struct stat file_stat;
+        if (stat(file->path.c_str(), &file_stat) == 0) {
+            file->last_size = file_stat.st_size;
+            file->dev = file_stat.st_dev;
+            file->ino = file_stat.st_ino;
+        }
+        off_t initial_size = file->last_size;
+
+        // resume where the checkpoint says; the first check catches up, or
+        // restarts the file if it was rotated since
+        dev_t dev;
+        ino_t ino;
+        off_t offset;
+        uint64_t fingerprint;
+        bool resume = file->checkpoint && ckpt_load(file->checkpoint, &dev, &ino, &offset, &fingerprint) && ino != 0;
+        if (resume) {
+            file->dev = dev;
+            file->ino = ino;
+            file->last_size = offset;
+            file->fingerprint = fingerprint;
+        } else {
+            file->fingerprint = ckpt_fingerprint(file->path.c_str(), file->last_size);
+        }
+
+        // print to console
+        //printf("[child %d] info | waiting for check commands...\n", pid);
+        if (resume) {
+            snprintf(log_msg, sizeof(log_msg),
+                     "[%s] info | monitoring file '%s' (initial size: %ld bytes, resuming at offset %ld)\n",
+                     file->tag, file->path.c_str(), initial_size, file->last_size);
+        } else {
+            snprintf(log_msg, sizeof(log_msg),
+                     "[%s] info | monitoring file '%s' (initial size: %ld bytes)\n",
+                     file->tag, file->path.c_str(), file->last_size);
+        }
+        fputs(log_msg, info);
+
+        // also send to logger
+        log_message(logger, t_config, file->id, file->last_size, log_msg);
+    }
+    fflush(stdout);
+
+    // event loop; returns when the parent closes the pipe
+    watch_loop(files, pipe_fd, logger, t_config);
+
+    const char* kind = t_config->worker_mode ? "worker" : "child";
+    fprintf(info, "[%s %d] info | pipe closed, exiting...\n", kind, pid);
+    fflush(stdout);
+
+    snprintf(log_msg, sizeof(log_msg), "[%s %d] info | pipe closed, exiting...\n", kind, pid);
+    log_message(logger, t_config, TAILBIN_NO_FILE, 0, log_msg);
+
     close(pipe_fd);
-    close(logger_fd);
+}
+
+// block until a 'stop' file appears in the current directory
+void wait_for_stop_file() {
+    int inotify_fd = inotify_init1(IN_CLOEXEC);
+    if (inotify_fd < 0 || inotify_add_watch(inotify_fd, ".", IN_CREATE | IN_MOVED_TO) < 0) {
+        // no inotify; look once a second
+        if (inotify_fd >= 0)
+            close(inotify_fd);
+        while (access("stop", F_OK) != 0)
+            sleep(1);
+        return;
+    }
+
+    // every entry created in the directory wakes the read; only 'stop' ends the wait
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (access("stop", F_OK) != 0) {
+        if (read(inotify_fd, buffer, sizeof(buffer)) < 0 && errno != EINTR)
+            sleep(1);
+    }
+
+    close(inotify_fd);
 }
 
 int main(int argc, char** argv) {
@@ -283,20 +917,90 @@ int main(int argc, char** argv) {
     // parse arguments for -l logfile
     // ------------------------------------------------------------------------
     const char* logfile = nullptr;
+    bool poll_mode = false;
+    bool raw_mode = false;
+    const char* checkpoint_file = nullptr;
+    int workers = 0; // 0: one child per file
+    std::vector<std::string> patterns;
+    bool binary_log = false;
     int first_file_arg = 1;
     
-    if (argc >= 3 && strcmp(argv[1], "-l") == 0) {
-        logfile = argv[2];
-        first_file_arg = 3;
+    while (first_file_arg < argc) {
+        if (strcmp(argv[first_file_arg], "-l") == 0 && first_file_arg + 1 < argc) {
+            logfile = argv[first_file_arg + 1];
+            first_file_arg += 2;
+        } else if (strcmp(argv[first_file_arg], "-p") == 0) {
+            poll_mode = true;
+            first_file_arg++;
+        } else if (strcmp(argv[first_file_arg], "-c") == 0 && first_file_arg + 1 < argc) {
+            checkpoint_file = argv[first_file_arg + 1];
+            first_file_arg += 2;
+        } else if (strcmp(argv[first_file_arg], "-r") == 0) {
+            raw_mode = true;
+            first_file_arg++;
+        } else if (strcmp(argv[first_file_arg], "-w") == 0 && first_file_arg + 1 < argc) {
+            workers = atoi(argv[first_file_arg + 1]);
+            if (workers < 1) {
+                fprintf(stderr, "[error] invalid number of workers '%s'\n", argv[first_file_arg + 1]);
+                return EXIT_FAILURE;
+            }
+            first_file_arg += 2;
+        } else if (strcmp(argv[first_file_arg], "--format=bin") == 0 || strcmp(argv[first_file_arg], "--format=text") == 0) {
+            binary_log = (strcmp(argv[first_file_arg], "--format=bin") == 0);
+            first_file_arg++;
+        } else if (strcmp(argv[first_file_arg], "-e") == 0 && first_file_arg + 1 < argc) {
+            patterns.push_back(argv[first_file_arg + 1]);
+            first_file_arg += 2;
+        } else if (strcmp(argv[first_file_arg], "-f") == 0 && first_file_arg + 1 < argc) {
+            if (!matcher_read_patterns(argv[first_file_arg + 1], patterns)) {
+                fprintf(stderr, "[error] cannot read patterns from '%s'\n", argv[first_file_arg + 1]);
+                return EXIT_FAILURE;
+            }
+            first_file_arg += 2;
+        } else {
+            break;
+        }
     }
     
     if (first_file_arg >= argc) {
-        fprintf(stderr, "usage: %s [-l logfile] <file1> [file2] ...\n", argv[0]);
+        fprintf(stderr, "usage: %s [-p] [-r] [-w workers] [-c checkpoint] [-e pattern] [-f patternfile] [--format=bin] [-l logfile] <file1> [file2] ...\n", argv[0]);
+        fprintf(stderr, "  -p  legacy polling; the parent sends a check command every second\n");
+        fprintf(stderr, "      (default: inotify/epoll, changes are picked up as they happen)\n");
+        fprintf(stderr, "  -r  raw; stdout carries only the new content, copied by the kernel\n");
+        fprintf(stderr, "      (splice/sendfile), messages go to stderr\n");
+        fprintf(stderr, "  -w  hash the files onto this many worker processes instead of\n");
+        fprintf(stderr, "      forking one child per file; each worker watches its whole shard\n");
+        fprintf(stderr, "  -c  keep the read offset of every file in this checkpoint file and\n");
+        fprintf(stderr, "      resume from it on the next run (rotated/truncated files from 0)\n");
+        fprintf(stderr, "  -e  only forward lines containing this string (repeatable); changes\n");
+        fprintf(stderr, "      without such a line are not reported\n");
+        fprintf(stderr, "  -f  as -e, with the strings of this file, one per line\n");
+        fprintf(stderr, "  --format=bin  log binary records to segment files <logfile>.NNNNNN.tlb\n");
+        fprintf(stderr, "      with a time index each, for 'tailq' (default: --format=text)\n");
         fprintf(stderr, "example: %s -l output.log *.txt\n", argv[0]);
+        fprintf(stderr, "example: %s -w 8 -l output.log logs/*.log\n", argv[0]);
+        fprintf(stderr, "example: %s -e ERROR -e WARN -l output.log logs/*.log\n", argv[0]);
+        fprintf(stderr, "example: %s --format=bin -l logs/tail logs/*.log\n", argv[0]);
         fprintf(stderr, "example: %s -l /dev/pts/0 *.txt\n", argv[0]);
         return EXIT_FAILURE;
     }
     
+    // line filter, shared by all monitors after the fork
+    tail_matcher* matcher = nullptr;
+    if (!patterns.empty()) {
+        matcher = matcher_create(patterns);
+        if (!matcher) {
+            fprintf(stderr, "[error] empty pattern\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    // segments need a name to go by
+    if (binary_log && !logfile) {
+        fprintf(stderr, "[error] --format=bin needs -l logfile\n");
+        return EXIT_FAILURE;
+    }
+
     // if no logfile specified, use stdout (via /dev/stdout)
     if (!logfile) {
         logfile = "/dev/stdout";
@@ -331,13 +1035,38 @@ int main(int argc, char** argv) {
     fprintf(stderr, "total arguments: %d\n", argc - first_file_arg);
     fprintf(stderr, "valid files. . : %lu\n", valid_files.size());
     fprintf(stderr, "skipped. . . . : %d\n", argc - first_file_arg - (int)valid_files.size());
-    fprintf(stderr, "logfile. . . . : %s\n", logfile);
+    fprintf(stderr, "logfile. . . . : %s%s\n", logfile, binary_log ? ".NNNNNN.tlb (binary)" : "");
+    fprintf(stderr, "engine . . . . : %s\n", poll_mode ? "polling (1 s)" : "inotify/epoll");
+    fprintf(stderr, "output . . . . : %s\n", raw_mode ? "raw content" : "tagged lines");
+    if (matcher) {
+        fprintf(stderr, "filter . . . . : %lu pattern(s)\n", patterns.size());
+    }
     
     if (valid_files.empty()) {
         fprintf(stderr, "[error] no valid files to process\n");
         return EXIT_FAILURE;
     }
     
+    // no more workers than files
+    if (workers > (int)valid_files.size()) {
+        workers = (int)valid_files.size();
+    }
+    if (workers) {
+        fprintf(stderr, "workers. . . . : %d\n", workers);
+    }
+    
+    // checkpoint; mapped before forking, every monitor updates its own entries
+    tail_checkpoint* checkpoint = nullptr;
+    if (checkpoint_file) {
+        ckpt_summary resume;
+        checkpoint = ckpt_open(checkpoint_file, valid_files, &resume);
+        if (!checkpoint) {
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "checkpoint . . : %s (%lu resumed, %lu rotated/truncated, %lu new)\n",
+                checkpoint_file, resume.resumed, resume.restarted, resume.added);
+    }
+    
     fprintf(stderr, "\n--- valid files for processing ---------------------\n");
     for (size_t i = 0; i < valid_files.size(); i++) {
         fprintf(stderr, "%lu. %s\n", i + 1, valid_files[i].c_str());
@@ -346,13 +1075,24 @@ int main(int argc, char** argv) {
     // ------------------------------------------------------------------------
     // task 2 & 3: create pipes and child processes for each valid file
     // ------------------------------------------------------------------------
-    fprintf(stderr, "\n--- processing files with child processes ----------\n");
+    // files of each monitoring process; a file per child, or the files hashed onto the workers
+    std::vector<std::vector<size_t> > shards(workers ? workers : valid_files.size());
+    std::hash<std::string> path_hash;
+    for (size_t i = 0; i < valid_files.size(); i++) {
+        shards[workers ? path_hash(valid_files[i]) % workers : i].push_back(i);
+    }
+    
+    if (workers) {
+        fprintf(stderr, "\n--- processing files with worker processes ---------\n");
+    } else {
+        fprintf(stderr, "\n--- processing files with child processes ----------\n");
+    }
     fprintf(stderr, "[parent] info | process ID: %d\n", getpid());
     
-    // create logger pipe
-    int logger_pipe[2];
-    if (pipe(logger_pipe) == -1) {
-        fprintf(stderr, "[parent] error | logger pipe creation failed\n");
+    // create logger ring; shared by all processes forked from here on
+    tail_ring* logger_ring = ring_create(RING_SIZE);
+    if (!logger_ring) {
+        fprintf(stderr, "[parent] error | logger ring creation failed\n");
         return EXIT_FAILURE;
     }
     
@@ -360,29 +1100,32 @@ int main(int argc, char** argv) {
     pid_t logger_pid = fork();
     if (logger_pid < 0) {
         fprintf(stderr, "[parent] error | fork failed for logger process\n");
-        close(logger_pipe[0]);
-        close(logger_pipe[1]);
+        ring_destroy(logger_ring);
         return EXIT_FAILURE;
     } else if (logger_pid == 0) {
         // logger child process
-        close(logger_pipe[1]); // close write end
-        logger_process(logger_pipe[0], logfile);
+        logger_process(logger_ring, logfile, binary_log ? &valid_files : nullptr);
         exit(EXIT_SUCCESS);
     }
     
-    // parent process - close read end, keep write end for monitoring children
-    close(logger_pipe[0]);
     fprintf(stderr, "[parent] info | created logger process %d\n", logger_pid);
     
     std::vector<pid_t> child_pids;
     std::vector<int> pipe_write_fds; // parent writes to these
     
-    for (size_t i = 0; i < valid_files.size(); i++) {
+    for (size_t i = 0; i < shards.size(); i++) {
+        // a hash may leave a worker without files
+        if (shards[i].empty()) {
+            continue;
+        }
+        
+        const char* what = workers ? "worker" : "file";
+        std::string name = workers ? std::to_string(i + 1) : valid_files[i];
         int pipefd[2];
         
         // create pipe for this child
         if (pipe(pipefd) == -1) {
-            fprintf(stderr, "[parent] error | pipe creation failed for file '%s'\n", valid_files[i].c_str());
+            fprintf(stderr, "[parent] error | pipe creation failed for %s '%s'\n", what, name.c_str());
             continue;
         }
         
@@ -390,7 +1133,7 @@ int main(int argc, char** argv) {
         
         if (pid < 0) {
             // fork failed
-            fprintf(stderr, "[parent] error | fork failed for file '%s'\n", valid_files[i].c_str());
+            fprintf(stderr, "[parent] error | fork failed for %s '%s'\n", what, name.c_str());
             close(pipefd[0]);
             close(pipefd[1]);
             continue;
@@ -405,9 +1148,29 @@ int main(int argc, char** argv) {
                 close(pipe_write_fds[j]);
             }
             
-            // monitor the file
+            // tag the files of this process
+            std::vector<watched_file> files(shards[i].size());
+            for (size_t j = 0; j < shards[i].size(); j++) {
+                files[j].path = valid_files[shards[i][j]];
+                files[j].dev = 0;
+                files[j].ino = 0;
+                files[j].wd = WATCH_NONE;
+                files[j].dirty = false;
+                files[j].missing = false;
+                files[j].replaced = false;
+                files[j].checkpoint = checkpoint ? ckpt_get(checkpoint, shards[i][j]) : nullptr;
+                files[j].id = (uint32_t)shards[i][j];
+                if (workers) {
+                    snprintf(files[j].tag, sizeof(files[j].tag), "worker %d:%lu", getpid(), shards[i][j] + 1);
+                } else {
+                    snprintf(files[j].tag, sizeof(files[j].tag), "child %d", getpid());
+                }
+            }
+            
+            // monitor the file(s)
             usleep(30000); // 30 ms; gives parent time to print info; keeps console output organized and readable
-            monitor_file(valid_files[i].c_str(), pipefd[0], logger_pipe[1]);
+            monitor_config config = { poll_mode, workers > 0, raw_mode, matcher, binary_log };
+            monitor_files(files, pipefd[0], logger_ring, &config);
             
             exit(EXIT_SUCCESS);
         } else {
@@ -419,7 +1182,11 @@ int main(int argc, char** argv) {
             child_pids.push_back(pid);
             pipe_write_fds.push_back(pipefd[1]);
             
-            fprintf(stderr, "[parent] info | created child process %d with pipe for file '%s'\n",pid, valid_files[i].c_str());
+            if (workers) {
+                fprintf(stderr, "[parent] info | created worker process %d with pipe for %lu file(s)\n", pid, shards[i].size());
+            } else {
+                fprintf(stderr, "[parent] info | created child process %d with pipe for file '%s'\n",pid, valid_files[i].c_str());
+            }
         }
 
         // small delay to avoid overwhelming output; keeps console output organized and readable
@@ -438,6 +1205,13 @@ int main(int argc, char** argv) {
     int check_count = 0;
     bool stop_requested = false;
     
+    // event mode: the children watch their files, the parent only waits for 'stop'
+    if (!poll_mode) {
+        wait_for_stop_file();
+        fprintf(stderr, "[parent] info | 'stop' file detected, initiating shutdown...\n");
+        stop_requested = true;
+    }
+    
     while (!stop_requested) {
         sleep(1);
         check_count++;
@@ -471,9 +1245,6 @@ int main(int argc, char** argv) {
         close(pipe_write_fds[i]);
     }
     
-    // close logger pipe write end to signal logger to exit
-    close(logger_pipe[1]);
-    
     // wait for all children to complete
     fprintf(stderr, "[parent] info | waiting for all child processes to complete...\n");
     int completed = 0;
@@ -484,14 +1255,26 @@ int main(int argc, char** argv) {
         if (finished_pid > 0) {
             completed++;
             if (WIFEXITED(status)) {
-                fprintf(stderr, "[parent] info | child process %d finished with exit code %d\n", 
-                       finished_pid, WEXITSTATUS(status));
+                fprintf(stderr, "[parent] info | %s process %d finished with exit code %d\n", 
+                       workers ? "worker" : "child", finished_pid, WEXITSTATUS(status));
             } else {
-                fprintf(stderr, "[parent] info | child process %d terminated abnormally\n", finished_pid);
+                fprintf(stderr, "[parent] info | %s process %d terminated abnormally\n", workers ? "worker" : "child", finished_pid);
             }
         }
     }
     
+    // no more records; the logger drains the ring and exits
+    ring_close(logger_ring);
+    
+    // all monitors are gone, the offsets are final
+    if (checkpoint) {
+        ckpt_close(checkpoint);
+    }
+    
+    if (matcher) {
+        matcher_destroy(matcher);
+    }
+    
     // wait for logger process
     int status;
     waitpid(logger_pid, &status, 0);
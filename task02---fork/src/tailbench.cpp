@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/inotify.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// end-to-end latency of tail: from the write() of a record to a watched file
+// until the logger has it in the -l logfile
+//
+// writer threads append stamped records to the files, tail runs on them with
+// the given options and the bench follows the logfile. the logger records only
+// sizes, so a record counts as delivered at the first "new size" of its file
+// at or past its end offset; the stamp in the record (CLOCK_MONOTONIC, ns)
+// is for reading tail's stdout by hand
+
+// tail is given up on after this long without reporting a file or delivering
+// a record while starting or catching up; tail -p forks a child per 100 ms and
+// checks them 30 ms apart, so only a stall counts
+#define BENCH_STALL_MS 15000
+
+// a record written but not seen in the log yet
+struct pending_write {
+    off_t    end;
+    uint64_t written_ns;
+};
+
+struct bench_file {
+    std::string               path;
+    int                       fd;
+    off_t                     size; // its writer only
+    std::mutex                lock;
+    std::deque<pending_write> pending;
+};
+
+struct bench_config {
+    int    files;
+    int    writers;
+    long   rate;   // records per second per writer, 0 for as fast as possible
+    int    seconds;
+    size_t record; // bytes per record, newline included
+};
+
+// the logfile as far as it has been read
+struct bench_log {
+    int         fd;
+    int         inotify_fd;
+    std::string partial;   // unfinished last line
+    bench_file* current;   // file of the change block being read
+    size_t      monitoring; // "monitoring file" reports so far
+    size_t      changes;    // change blocks so far
+};
+
+uint64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------
+// writers
+// ----------------------------------------------------------------------------
+
+// append one record stamped now; false if the write failed
+bool write_record(bench_file* t_file, std::vector<char>& t_record, int t_writer, unsigned long t_seq) {
+    uint64_t stamp = now_ns();
+    int len = snprintf(t_record.data(), t_record.size(), "bench %d %lu %lu ", t_writer, t_seq, (unsigned long)stamp);
+    if (len < 0 || (size_t)len >= t_record.size()) {
+        len = (int)t_record.size() - 1;
+    }
+    memset(t_record.data() + len, 'x', t_record.size() - len - 1);
+    t_record[t_record.size() - 1] = '\n';
+
+    // known before the write, the logger may be quicker than the return
+    {
+        std::lock_guard<std::mutex> guard(t_file->lock);
+        t_file->size += t_record.size();
+        t_file->pending.push_back({ t_file->size, stamp });
+    }
+
+    if (write(t_file->fd, t_record.data(), t_record.size()) != (ssize_t)t_record.size()) {
+        fprintf(stderr, "[bench] error | cannot write '%s': %s\n", t_file->path.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void writer_thread(int t_index, const bench_config* t_config, std::vector<bench_file*>* t_files,
+                   std::atomic<bool>* t_stop, std::atomic<uint64_t>* t_written) {
+    // the files of this writer; one record to each in turn
+    std::vector<bench_file*> own;
+    for (size_t i = t_index; i < t_files->size(); i += t_config->writers) {
+        own.push_back((*t_files)[i]);
+    }
+    if (own.empty()) {
+        return;
+    }
+
+    std::vector<char> record(t_config->record);
+    uint64_t interval = t_config->rate ? 1000000000ULL / t_config->rate : 0;
+    uint64_t next = now_ns();
+    unsigned long seq = 0;
+
+    for (size_t turn = 0; !t_stop->load(std::memory_order_relaxed); turn++) {
+        bench_file* file = own[turn % own.size()];
+
+        // on a fixed schedule, so a slow tail does not slow the writers down
+        if (interval) {
+            next += interval;
+            struct timespec until = { (time_t)(next / 1000000000ULL), (long)(next % 1000000000ULL) };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+        }
+
+        if (!write_record(file, record, t_index, seq++)) {
+            t_stop->store(true);
+            return;
+        }
+        t_written->fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// log follower
+// ----------------------------------------------------------------------------
+
+// one line of the logfile; a "new size" in a change block delivers the writes it covers
+void parse_line(bench_log* t_log, const std::string& t_line, std::unordered_map<std::string, bench_file*>* t_paths,
+                uint64_t t_seen, std::vector<uint64_t>* t_latencies) {
+    const char* text = t_line.c_str();
+    const char* field;
+
+    if (strstr(text, "] info | monitoring file '")) {
+        t_log->monitoring++;
+    } else if ((field = strstr(text, "] file. . . . . . : "))) {
+        std::unordered_map<std::string, bench_file*>::iterator found = t_paths->find(field + 20);
+        t_log->current = (found != t_paths->end()) ? found->second : nullptr;
+    } else if ((field = strstr(text, "] new size. . . . : ")) && t_log->current) {
+        off_t size = atol(field + 20);
+        bench_file* file = t_log->current;
+        t_log->changes++;
+
+        std::lock_guard<std::mutex> guard(file->lock);
+        while (!file->pending.empty() && file->pending.front().end <= size) {
+            t_latencies->push_back(t_seen - file->pending.front().written_ns);
+            file->pending.pop_front();
+        }
+        t_log->current = nullptr;
+    }
+}
+
+// read what the logger has written so far, waiting up to t_timeout_ms for more
+void follow_log(bench_log* t_log, std::unordered_map<std::string, bench_file*>* t_paths,
+                std::vector<uint64_t>* t_latencies, int t_timeout_ms) {
+    char buffer[65536];
+    ssize_t got = read(t_log->fd, buffer, sizeof(buffer));
+
+    if (got <= 0) {
+        struct pollfd watch = { t_log->inotify_fd, POLLIN, 0 };
+        if (poll(&watch, 1, t_timeout_ms) > 0) {
+            char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            if (read(t_log->inotify_fd, events, sizeof(events)) < 0) {
+                // drained either way
+            }
+        }
+        return;
+    }
+
+    // one timestamp for the batch; the records in it arrived by now
+    uint64_t seen = now_ns();
+    t_log->partial.append(buffer, got);
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = t_log->partial.find('\n', start)) != std::string::npos) {
+        parse_line(t_log, t_log->partial.substr(start, newline - start), t_paths, seen, t_latencies);
+        start = newline + 1;
+    }
+    t_log->partial.erase(0, start);
+}
+
+// ----------------------------------------------------------------------------
+
+uint64_t percentile(const std::vector<uint64_t>& t_sorted, double t_fraction) {
+    if (t_sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(t_fraction * t_sorted.size());
+    return t_sorted[std::min(index, t_sorted.size() - 1)];
+}
+
+size_t pending_total(const std::vector<bench_file*>& t_files) {
+    size_t total = 0;
+    for (size_t i = 0; i < t_files.size(); i++) {
+        std::lock_guard<std::mutex> guard(t_files[i]->lock);
+        total += t_files[i]->pending.size();
+    }
+    return total;
+}
+
+int main(int argc, char** argv) {
+    // ------------------------------------------------------------------------
+    // parse arguments; everything after -- goes to tail
+    // ------------------------------------------------------------------------
+    bench_config config = { 16, 4, 100, 10, 64 };
+    const char* tail_binary = "./tail";
+    bool keep = false;
+    int arg = 1;
+
+    while (arg < argc) {
+        if (strcmp(argv[arg], "--") == 0) {
+            arg++;
+            break;
+        } else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc) {
+            config.files = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            config.writers = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+            config.rate = atol(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc) {
+            config.seconds = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) {
+            config.record = (size_t)atol(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-x") == 0 && arg + 1 < argc) {
+            tail_binary = argv[arg + 1];
+            arg += 2;
+        } else if (strcmp(argv[arg], "-k") == 0) {
+            keep = true;
+            arg++;
+        } else {
+            fprintf(stderr, "usage: %s [-n files] [-t writers] [-r rate] [-d seconds] [-s size] [-x tail] [-k] [-- tail options]\n", argv[0]);
+            fprintf(stderr, "  -n  watched files (default 16)\n");
+            fprintf(stderr, "  -t  writer threads, the files are dealt out among them (default 4)\n");
+            fprintf(stderr, "  -r  records per second per writer, 0 for as fast as possible (default 100)\n");
+            fprintf(stderr, "  -d  seconds of writing (default 10)\n");
+            fprintf(stderr, "  -s  bytes per record (default 64)\n");
+            fprintf(stderr, "  -x  tail binary (default ./tail)\n");
+            fprintf(stderr, "  -k  keep the work directory (files, bench.log, tail.err)\n");
+            fprintf(stderr, "example: %s -n 64 -t 8 -r 1000 -- -p\n", argv[0]);
+            fprintf(stderr, "example: %s -n 1000 -t 4 -r 0 -- -w 4\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    std::vector<const char*> tail_options(argv + arg, argv + argc);
+
+    // latencies come from the change lines of the text log
+    for (size_t i = 0; i < tail_options.size(); i++) {
+        if (strcmp(tail_options[i], "--format=bin") == 0) {
+            fprintf(stderr, "[bench] error | --format=bin is not supported, latencies are read from the text log\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (config.files < 1 || config.writers < 1 || config.rate < 0 || config.seconds < 1 || config.record < 32) {
+        fprintf(stderr, "[bench] error | invalid arguments (at least 1 file, writer, second and 32 bytes per record)\n");
+        return EXIT_FAILURE;
+    }
+
+    char tail_path[PATH_MAX];
+    if (!realpath(tail_binary, tail_path)) {
+        fprintf(stderr, "[bench] error | cannot find tail binary '%s'\n", tail_binary);
+        return EXIT_FAILURE;
+    }
+
+    // ------------------------------------------------------------------------
+    // work directory with the files; tail runs in it, so 'stop' goes there
+    // ------------------------------------------------------------------------
+    char workdir[] = "/tmp/tailbench-XXXXXX";
+    if (!mkdtemp(workdir)) {
+        fprintf(stderr, "[bench] error | cannot create work directory: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    std::vector<bench_file*> files;
+    std::unordered_map<std::string, bench_file*> paths;
+    for (int i = 0; i < config.files; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "file-%04d.log", i);
+
+        bench_file* file = new bench_file;
+        file->path = name;
+        file->size = 0;
+        file->fd = open((std::string(workdir) + "/" + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (file->fd < 0) {
+            fprintf(stderr, "[bench] error | cannot create '%s': %s\n", name, strerror(errno));
+            return EXIT_FAILURE;
+        }
+        files.push_back(file);
+        paths[name] = file;
+    }
+
+    // the logger truncates the logfile when it opens it, follow it from there
+    std::string log_path = std::string(workdir) + "/bench.log";
+    bench_log log;
+    log.fd = open(log_path.c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0644);
+    log.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    log.current = nullptr;
+    log.monitoring = 0;
+    log.changes = 0;
+    if (log.fd < 0 || log.inotify_fd < 0 || inotify_add_watch(log.inotify_fd, log_path.c_str(), IN_MODIFY) < 0) {
+        fprintf(stderr, "[bench] error | cannot follow '%s': %s\n", log_path.c_str(), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // ------------------------------------------------------------------------
+    // start tail: <tail> [options] -l bench.log file-0000.log ...
+    // ------------------------------------------------------------------------
+    std::vector<char*> tail_argv;
+    tail_argv.push_back(tail_path);
+    for (size_t i = 0; i < tail_options.size(); i++) {
+        tail_argv.push_back((char*)tail_options[i]);
+    }
+    tail_argv.push_back((char*)"-l");
+    tail_argv.push_back((char*)"bench.log");
+    for (size_t i = 0; i < files.size(); i++) {
+        tail_argv.push_back((char*)files[i]->path.c_str());
+    }
+    tail_argv.push_back(nullptr);
+
+    pid_t tail_pid = fork();
+    if (tail_pid < 0) {
+        fprintf(stderr, "[bench] error | fork failed: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (tail_pid == 0) {
+        // the content goes to stdout, only the logfile is measured
+        int null_fd = open("/dev/null", O_WRONLY);
+        int err_fd = open((std::string(workdir) + "/tail.err").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (null_fd < 0 || err_fd < 0 || chdir(workdir) != 0) {
+            _exit(EXIT_FAILURE);
+        }
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(err_fd, STDERR_FILENO);
+        execv(tail_path, tail_argv.data());
+        _exit(EXIT_FAILURE);
+    }
+
+    // warm-up: a record to every file once all are reported, measuring starts
+    // when tail has delivered them (with -p the first check comes ~2 s late)
+    std::vector<uint64_t> latencies;
+    std::vector<char> record(config.record);
+    bool warm = false;
+    size_t progress = 0;
+    uint64_t deadline = 0;
+    while (waitpid(tail_pid, NULL, WNOHANG) == 0) {
+        follow_log(&log, &paths, &latencies, 50);
+
+        if (log.monitoring + latencies.size() != progress || !deadline) {
+            progress = log.monitoring + latencies.size();
+            deadline = now_ns() + BENCH_STALL_MS * 1000000ULL;
+        } else if (now_ns() > deadline) {
+            break;
+        }
+
+        if (!warm && log.monitoring >= files.size()) {
+            for (size_t i = 0; i < files.size(); i++) {
+                write_record(files[i], record, -1, 0);
+            }
+            warm = true;
+        } else if (warm && pending_total(files) == 0) {
+            break;
+        }
+    }
+    if (!warm || pending_total(files) > 0) {
+        fprintf(stderr, "[bench] error | tail did not start up (%lu of %lu files reported), see %s/tail.err\n",
+                log.monitoring, files.size(), workdir);
+        kill(tail_pid, SIGTERM);
+        waitpid(tail_pid, NULL, 0);
+        return EXIT_FAILURE;
+    }
+    latencies.clear();
+
+    fprintf(stderr, "--- tailbench ---------------------------------------\n");
+    fprintf(stderr, "tail . . . . . : %s", tail_path);
+    for (size_t i = 0; i < tail_options.size(); i++) {
+        fprintf(stderr, " %s", tail_options[i]);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "files. . . . . : %d\n", config.files);
+    fprintf(stderr, "writers. . . . : %d\n", config.writers);
+    if (config.rate) {
+        fprintf(stderr, "rate . . . . . : %ld records/s per writer\n", config.rate);
+    } else {
+        fprintf(stderr, "rate . . . . . : unthrottled\n");
+    }
+    fprintf(stderr, "record . . . . : %lu bytes\n", config.record);
+    fprintf(stderr, "duration . . . : %d s\n", config.seconds);
+    fprintf(stderr, "work directory : %s\n", workdir);
+
+    // ------------------------------------------------------------------------
+    // write for the duration while following the log, then let tail catch up
+    // ------------------------------------------------------------------------
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> written(0);
+    std::vector<std::thread> writers;
+
+    uint64_t started = now_ns();
+    for (int i = 0; i < config.writers; i++) {
+        writers.push_back(std::thread(writer_thread, i, &config, &files, &stop, &written));
+    }
+
+    deadline = started + config.seconds * 1000000000ULL;
+    while (now_ns() < deadline && !stop.load()) {
+        follow_log(&log, &paths, &latencies, 50);
+    }
+    stop.store(true);
+    for (size_t i = 0; i < writers.size(); i++) {
+        writers[i].join();
+    }
+    uint64_t stopped = now_ns();
+
+    progress = latencies.size();
+    deadline = stopped + BENCH_STALL_MS * 1000000ULL;
+    while (pending_total(files) > 0 && now_ns() < deadline) {
+        follow_log(&log, &paths, &latencies, 50);
+
+        if (latencies.size() != progress) {
+            progress = latencies.size();
+            deadline = now_ns() + BENCH_STALL_MS * 1000000ULL;
+        }
+    }
+    uint64_t drained = now_ns();
+
+    // stop tail the usual way
+    int stop_fd = open((std::string(workdir) + "/stop").c_str(), O_WRONLY | O_CREAT, 0644);
+    if (stop_fd >= 0) {
+        close(stop_fd);
+    }
+    // cpu of tail with its monitors and logger, start-up included
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    wait4(tail_pid, NULL, 0, &usage);
+
+    // ------------------------------------------------------------------------
+    // report
+    // ------------------------------------------------------------------------
+    std::sort(latencies.begin(), latencies.end());
+    double write_seconds = (stopped - started) / 1e9;
+    double total_seconds = (drained - started) / 1e9;
+    size_t lost = pending_total(files);
+    double cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    double cpu_per_change = log.changes ? cpu_seconds * 1e6 / log.changes : 0.0;
+
+    fprintf(stderr, "\n--- results ----------------------------------------\n");
+    fprintf(stderr, "written. . . . : %lu records in %.2f s (%.0f records/s)\n",
+            (unsigned long)written.load(), write_seconds, written.load() / write_seconds);
+    fprintf(stderr, "delivered. . . : %lu records in %.2f s (%.0f records/s)\n",
+            latencies.size(), total_seconds, latencies.size() / total_seconds);
+    fprintf(stderr, "not delivered. : %lu records\n", lost);
+    fprintf(stderr, "latency p50. . : %.1f us\n", percentile(latencies, 0.50) / 1e3);
+    fprintf(stderr, "latency p99. . : %.1f us\n", percentile(latencies, 0.99) / 1e3);
+    fprintf(stderr, "latency p999 . : %.1f us\n", percentile(latencies, 0.999) / 1e3);
+    fprintf(stderr, "latency max. . : %.1f us\n", latencies.empty() ? 0.0 : latencies.back() / 1e3);
+    fprintf(stderr, "tail cpu . . . : %.2f s for %lu changes (%.1f us per change)\n",
+            cpu_seconds, log.changes, cpu_per_change);
+
+    // one line for scripts
+    printf("files=%d writers=%d rate=%ld written=%lu delivered=%lu lost=%lu records_s=%.0f p50_us=%.1f p99_us=%.1f p999_us=%.1f cpu_us_change=%.1f\n",
+           config.files, config.writers, config.rate, (unsigned long)written.load(), latencies.size(), lost,
+           latencies.size() / total_seconds, percentile(latencies, 0.50) / 1e3,
+           percentile(latencies, 0.99) / 1e3, percentile(latencies, 0.999) / 1e3, cpu_per_change);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        close(files[i]->fd);
+        if (!keep) {
+            unlink((std::string(workdir) + "/" + files[i]->path).c_str());
+        }
+        delete files[i];
+    }
+    close(log.fd);
+    close(log.inotify_fd);
+    if (!keep) {
+        unlink(log_path.c_str());
+        unlink((std::string(workdir) + "/tail.err").c_str());
+        unlink((std::string(workdir) + "/stop").c_str());
+        rmdir(workdir);
+    }
+
+    return lost ? EXIT_FAILURE : EXIT_SUCCESS;
+}
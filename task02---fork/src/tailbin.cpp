@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "tailbin.h"
+
+#define SEGMENT_IOV 64 // records per writev
+
+struct bin_log {
+    std::string              base;
+    std::vector<std::string> files;
+    uint32_t                 number;     // of the open segment, or the last existing one
+    int                      fd;         // segment, -1 before the first record
+    int                      index_fd;
+    uint64_t                 size;       // of the open segment
+    uint64_t                 next_index; // offset that gets the next index entry
+    uint64_t                 last;       // timestamp of the last record
+    std::vector<bin_index>   index;      // entries of the current batch
+};
+
+size_t bin_format(char* t_buffer, uint16_t t_kind, uint32_t t_file_id, off_t t_old_size, off_t t_new_size,
+                  const char* t_payload, size_t t_payload_len) {
+    if (t_payload_len > TAILBIN_PAYLOAD)
+        t_payload_len = TAILBIN_PAYLOAD;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    bin_record record;
+    record.timestamp = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    record.file_id = t_file_id;
+    record.pid = getpid();
+    record.old_size = t_old_size;
+    record.new_size = t_new_size;
+    record.payload_len = (uint32_t)t_payload_len;
+    record.kind = t_kind;
+    record.reserved = 0;
+
+    size_t len = TAILBIN_RECORD(t_payload_len);
+    memcpy(t_buffer, &record, sizeof(record));
+    memcpy(t_buffer + sizeof(record), t_payload, t_payload_len);
+    memset(t_buffer + sizeof(record) + t_payload_len, 0, len - sizeof(record) - t_payload_len);
+
+    return len;
+}
+
+// ----------------------------------------------------------------------------
+
+static std::string segment_path(const std::string& t_base, uint32_t t_number, const char* t_suffix) {
+    char name[32];
+    snprintf(name, sizeof(name), ".%06u.%s", t_number, t_suffix);
+    return t_base + name;
+}
+
+static bool write_all(int t_fd, struct iovec* t_iov, int t_count) {
+    while (t_count > 0) {
+        ssize_t written = writev(t_fd, t_iov, t_count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        while (t_count > 0 && (size_t)written >= t_iov->iov_len) {
+            written -= t_iov->iov_len;
+            t_iov++;
+            t_count--;
+        }
+        if (t_count > 0) {
+            t_iov->iov_base = (char*)t_iov->iov_base + written;
+            t_iov->iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+// the index entries of the batch go out after its records, so an entry never
+// points past the end of the segment
+static bool flush_index(bin_log* t_log) {
+    if (t_log->index.empty())
+        return true;
+
+    struct iovec iov = { t_log->index.data(), t_log->index.size() * sizeof(bin_index) };
+    t_log->index.clear();
+
+    return write_all(t_log->index_fd, &iov, 1);
+}
+
+static void close_segment(bin_log* t_log) {
+    if (t_log->fd < 0)
+        return;
+
+    flush_index(t_log);
+    close(t_log->fd);
+    close(t_log->index_fd);
+    t_log->fd = -1;
+    t_log->index_fd = -1;
+}
+
+static void add_index(bin_log* t_log, uint64_t t_timestamp) {
+    if (t_log->size < t_log->next_index)
+        return;
+
+    bin_index entry = { t_timestamp, t_log->size };
+    t_log->index.push_back(entry);
+    t_log->next_index = (t_log->size / TAILBIN_STRIDE + 1) * TAILBIN_STRIDE;
+}
+
+// the next segment, with its first record at t_timestamp; header and file table
+static bool open_segment(bin_log* t_log, uint64_t t_timestamp) {
+    close_segment(t_log);
+    t_log->number++;
+
+    std::string path = segment_path(t_log->base, t_log->number, "tlb");
+    std::string index_path = segment_path(t_log->base, t_log->number, "tli");
+    t_log->fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    t_log->index_fd = open(index_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (t_log->fd < 0 || t_log->index_fd < 0) {
+        fprintf(stderr, "[logger %d] error | cannot create segment '%s': %s\n", getpid(), path.c_str(), strerror(errno));
+        if (t_log->fd >= 0)
+            close(t_log->fd);
+        if (t_log->index_fd >= 0)
+            close(t_log->index_fd);
+        t_log->fd = -1;
+        t_log->index_fd = -1;
+        return false;
+    }
+
+    char header[TAILBIN_HEADER];
+    uint32_t version = TAILBIN_VERSION;
+    memset(header, 0, sizeof(header));
+    memcpy(header, TAILBIN_MAGIC, 4);
+    memcpy(header + 4, &version, sizeof(version));
+    memcpy(header + 8, &t_log->number, sizeof(t_log->number));
+    memcpy(header + 16, &t_timestamp, sizeof(t_timestamp));
+
+    struct iovec iov = { header, sizeof(header) };
+    if (!write_all(t_log->fd, &iov, 1))
+        return false;
+    t_log->size = TAILBIN_HEADER;
+    t_log->next_index = 0;
+
+    // file table, stamped with the first record's time
+    std::vector<char> table;
+    for (size_t i = 0; i < t_log->files.size(); i++) {
+        const std::string& path = t_log->files[i];
+        char record[TAILBIN_RECORD(TAILBIN_PAYLOAD)];
+        size_t len = bin_format(record, TAILBIN_FILE, (uint32_t)i, 0, 0, path.data(), path.size());
+        memcpy(record, &t_timestamp, sizeof(t_timestamp));
+
+        add_index(t_log, t_timestamp);
+        table.insert(table.end(), record, record + len);
+        t_log->size += len;
+    }
+
+    iov.iov_base = table.data();
+    iov.iov_len = table.size();
+    return write_all(t_log->fd, &iov, 1) && flush_index(t_log);
+}
+
+bin_log* bin_open(const char* t_base, const std::vector<std::string>& t_files) {
+    bin_log* log = new bin_log;
+    log->base = t_base;
+    log->files = t_files;
+    log->fd = -1;
+    log->index_fd = -1;
+    log->size = 0;
+    log->next_index = 0;
+    log->last = 0;
+
+    // continue after the segments of earlier runs
+    std::vector<bin_segment> existing = bin_segments(t_base);
+    log->number = existing.empty() ? 0 : existing.back().number;
+    if (!existing.empty())
+        log->last = existing.back().first;
+
+    // fail now rather than on the first record
+    std::string probe = segment_path(log->base, log->number + 1, "tlb");
+    int fd = open(probe.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno != EEXIST) {
+        fprintf(stderr, "[logger %d] error | cannot create segment '%s': %s\n", getpid(), probe.c_str(), strerror(errno));
+        delete log;
+        return nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        unlink(probe.c_str());
+    }
+
+    return log;
+}
+
+bool bin_write(bin_log* t_log, struct iovec* t_records, int t_count) {
+    struct iovec out[SEGMENT_IOV];
+    int pending = 0;
+    bool ok = true;
+
+    for (int i = 0; i < t_count && ok; i++) {
+        if (t_records[i].iov_len < sizeof(bin_record))
+            continue;
+
+        // the record is ours until released; only its time may change
+        bin_record* record = (bin_record*)t_records[i].iov_base;
+        if (record->timestamp < t_log->last)
+            record->timestamp = t_log->last;
+        t_log->last = record->timestamp;
+
+        if (t_log->fd < 0 || t_log->size + t_records[i].iov_len > TAILBIN_SEGMENT || pending == SEGMENT_IOV) {
+            if (pending > 0)
+                ok = write_all(t_log->fd, out, pending) && flush_index(t_log);
+            pending = 0;
+
+            if (ok && (t_log->fd < 0 || t_log->size + t_records[i].iov_len > TAILBIN_SEGMENT))
+                ok = open_segment(t_log, record->timestamp);
+            if (!ok)
+                break;
+        }
+
+        add_index(t_log, record->timestamp);
+        out[pending++] = t_records[i];
+        t_log->size += t_records[i].iov_len;
+    }
+
+    if (ok && pending > 0)
+        ok = write_all(t_log->fd, out, pending) && flush_index(t_log);
+
+    return ok;
+}
+
+void bin_close(bin_log* t_log) {
+    close_segment(t_log);
+    delete t_log;
+}
+
+// ----------------------------------------------------------------------------
+
+std::vector<bin_segment> bin_segments(const char* t_base) {
+    std::vector<bin_segment> segments;
+
+    std::string base = t_base;
+    size_t slash = base.rfind('/');
+    std::string dir = (slash == std::string::npos) ? "." : base.substr(0, slash + 1);
+    std::string prefix = (slash == std::string::npos) ? base : base.substr(slash + 1);
+
+    DIR* listing = opendir(dir.c_str());
+    if (!listing)
+        return segments;
+
+    // <prefix>.<number>.tlb
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL) {
+        const char* name = entry->d_name;
+        size_t len = strlen(name);
+        if (len < prefix.size() + 6 || strncmp(name, prefix.c_str(), prefix.size()) != 0 ||
+            name[prefix.size()] != '.' || strcmp(name + len - 4, ".tlb") != 0)
+            continue;
+
+        char* end;
+        unsigned long number = strtoul(name + prefix.size() + 1, &end, 10);
+        if (end != name + len - 4)
+            continue;
+
+        bin_segment segment;
+        segment.path = segment_path(base, (uint32_t)number, "tlb");
+        segment.number = (uint32_t)number;
+        segment.first = 0;
+
+        // a segment without records yet (created, or never written) is left out
+        char header[TAILBIN_HEADER];
+        int fd = open(segment.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        ssize_t got = read(fd, header, sizeof(header));
+        close(fd);
+        if (got == TAILBIN_HEADER && memcmp(header, TAILBIN_MAGIC, 4) == 0) {
+            memcpy(&segment.first, header + 16, sizeof(segment.first));
+            segments.push_back(segment);
+        }
+    }
+    closedir(listing);
+
+    std::sort(segments.begin(), segments.end(),
+              [](const bin_segment& a, const bin_segment& b) { return a.number < b.number; });
+
+    return segments;
+}
+
+uint64_t bin_seek(const bin_segment& t_segment, uint64_t t_timestamp) {
+    std::string index_path = t_segment.path.substr(0, t_segment.path.size() - 3) + "tli";
+    int fd = open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return TAILBIN_HEADER;
+
+    // the last entry before t_timestamp; every record before it is earlier
+    struct stat index_stat;
+    uint64_t offset = TAILBIN_HEADER;
+    if (fstat(fd, &index_stat) == 0) {
+        size_t low = 0;
+        size_t high = index_stat.st_size / sizeof(bin_index);
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            bin_index entry;
+            if (pread(fd, &entry, sizeof(entry), middle * sizeof(bin_index)) != sizeof(entry))
+                break;
+
+            if (entry.timestamp < t_timestamp) {
+                offset = entry.offset;
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+    }
+    close(fd);
+
+    return offset;
+}
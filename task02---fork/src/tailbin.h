@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+// binary logger output ('tail --format=bin -l base') and its reader ('tailq')
+//
+//   segment  <base>.<nnnnnn>.tlb; a TAILBIN_HEADER byte header ("TLB1",
+//            version, segment number, timestamp of the first record), then
+//            records: bin_record, payload, zero padding to 8 bytes
+//   index    <base>.<nnnnnn>.tli; a bin_index entry (timestamp, offset) for
+//            the first record at or after every TAILBIN_STRIDE bytes
+//
+// every segment starts with a TAILBIN_FILE record per monitored file (file id
+// -> path), so it can be read on its own. a run appends a new segment after
+// the existing ones and starts the next when one reaches TAILBIN_SEGMENT.
+// the logger keeps the timestamps non-decreasing over the log (a record that
+// lost the race into the ring takes the time of the one before it), so a
+// time range is found by binary search over the segments and then over the
+// index of the first one, without reading the records before it
+
+#define TAILBIN_MAGIC   "TLB1"
+#define TAILBIN_VERSION 1
+#define TAILBIN_HEADER  64
+#define TAILBIN_SEGMENT (64 << 20) // bytes per segment before the next one
+#define TAILBIN_STRIDE  (64 << 10) // segment bytes per index entry
+#define TAILBIN_PAYLOAD 1024       // payload bytes of a record at most
+
+// record kinds
+#define TAILBIN_FILE   1 // payload: path of file_id
+#define TAILBIN_CHANGE 2 // file_id grew from old_size to new_size
+#define TAILBIN_INFO   3 // payload: message of the monitor
+
+#define TAILBIN_NO_FILE 0xffffffffu // file_id of a message about no file
+
+struct bin_record {
+    uint64_t timestamp;   // CLOCK_REALTIME, ns
+    uint32_t file_id;     // index of the file on the command line
+    int32_t  pid;         // monitor
+    int64_t  old_size;
+    int64_t  new_size;
+    uint32_t payload_len;
+    uint16_t kind;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(bin_record) == 40, "binary record layout");
+
+struct bin_index {
+    uint64_t timestamp;
+    uint64_t offset;
+};
+
+#define TAILBIN_RECORD(payload_len) ((sizeof(bin_record) + (payload_len) + 7) & ~(size_t)7)
+
+// ----------------------------------------------------------------------------
+// monitors and logger
+
+// one record stamped now into t_buffer (at least TAILBIN_RECORD(TAILBIN_PAYLOAD)
+// bytes), payload cut to TAILBIN_PAYLOAD; returns its length
+size_t bin_format(char* t_buffer, uint16_t t_kind, uint32_t t_file_id, off_t t_old_size, off_t t_new_size,
+                  const char* t_payload, size_t t_payload_len);
+
+struct bin_log;
+
+// the next segment after the existing ones of t_base; t_files are the paths
+// by file id. nullptr on error
+bin_log* bin_open(const char* t_base, const std::vector<std::string>& t_files);
+
+// append records as made by bin_format; starts segments as needed
+bool bin_write(bin_log* t_log, struct iovec* t_records, int t_count);
+void bin_close(bin_log* t_log);
+
+// ----------------------------------------------------------------------------
+// reader
+
+struct bin_segment {
+    std::string path;   // the .tlb file; the index is next to it
+    uint32_t    number;
+    uint64_t    first;  // timestamp of the first record
+};
+
+// the segments of t_base in order
+std::vector<bin_segment> bin_segments(const char* t_base);
+
+// offset in the segment at which no earlier record is at or after
+// t_timestamp, from its index; TAILBIN_HEADER without one
+uint64_t bin_seek(const bin_segment& t_segment, uint64_t t_timestamp);
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#include "tailckpt.h"
+
+struct tail_checkpoint {
+    int    fd;
+    char*  map;
+    size_t map_len;
+    size_t count;
+};
+
+// FNV-1a; entries are looked up by the hash of the full path
+static uint64_t fnv_hash(const char* t_data, size_t t_len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < t_len; i++) {
+        hash ^= (uint8_t)t_data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t path_hash(const std::string& t_path) {
+    return fnv_hash(t_path.data(), t_path.size());
+}
+
+uint64_t ckpt_fingerprint_data(const char* t_end, off_t t_offset) {
+    if (t_offset <= 0)
+        return 0;
+
+    size_t len = (t_offset > CKPT_TAIL) ? CKPT_TAIL : (size_t)t_offset;
+
+    // nonzero for any content, so 0 stays 'nothing read yet'
+    return fnv_hash(t_end - len, len) | 1;
+}
+
+uint64_t ckpt_fingerprint_fd(int t_fd, off_t t_offset) {
+    if (t_offset <= 0)
+        return 0;
+
+    char tail[CKPT_TAIL];
+    off_t from = (t_offset > CKPT_TAIL) ? t_offset - CKPT_TAIL : 0;
+    ssize_t got = pread(t_fd, tail, t_offset - from, from);
+
+    return (got == t_offset - from) ? ckpt_fingerprint_data(tail + got, t_offset) : 0;
+}
+
+uint64_t ckpt_fingerprint(const char* t_path, off_t t_offset) {
+    if (t_offset <= 0)
+        return 0;
+
+    int fd = open(t_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+
+    uint64_t fingerprint = ckpt_fingerprint_fd(fd, t_offset);
+    close(fd);
+
+    return fingerprint;
+}
+
+static ckpt_entry* entry_at(char* t_map, size_t t_index) {
+    return (ckpt_entry*)(t_map + CKPT_HEADER + t_index * CKPT_ENTRY);
+}
+
+// ----------------------------------------------------------------------------
+
+bool ckpt_load(const ckpt_entry* t_entry, dev_t* t_dev, ino_t* t_ino, off_t* t_offset, uint64_t* t_fingerprint) {
+    for (int attempt = 0; attempt < 100; attempt++) {
+        uint32_t seq = t_entry->seq.load(std::memory_order_acquire);
+        if (seq & 1)
+            continue; // being written, or torn by a crash if it stays odd
+
+        *t_dev = (dev_t)t_entry->dev.load(std::memory_order_relaxed);
+        *t_ino = (ino_t)t_entry->ino.load(std::memory_order_relaxed);
+        *t_offset = (off_t)t_entry->offset.load(std::memory_order_relaxed);
+        *t_fingerprint = t_entry->fingerprint.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (t_entry->seq.load(std::memory_order_relaxed) == seq)
+            return true;
+    }
+
+    return false;
+}
+
+void ckpt_store(ckpt_entry* t_entry, dev_t t_dev, ino_t t_ino, off_t t_offset, uint64_t t_fingerprint) {
+    // only the monitor of the file writes its entry
+    uint32_t seq = t_entry->seq.load(std::memory_order_relaxed);
+    t_entry->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    t_entry->dev.store((uint64_t)t_dev, std::memory_order_relaxed);
+    t_entry->ino.store((uint64_t)t_ino, std::memory_order_relaxed);
+    t_entry->offset.store((int64_t)t_offset, std::memory_order_relaxed);
+    t_entry->fingerprint.store(t_fingerprint, std::memory_order_relaxed);
+
+    t_entry->seq.store(seq + 2, std::memory_order_release);
+}
+
+// ----------------------------------------------------------------------------
+
+// map the previous checkpoint read-only; an unusable one counts as empty
+static char* map_previous(const char* t_path, size_t* t_len, size_t* t_count) {
+    *t_len = 0;
+    *t_count = 0;
+
+    int fd = open(t_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr; // first run
+
+    struct stat file_stat;
+    char* map = nullptr;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= CKPT_HEADER) {
+        map = (char*)mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+            map = nullptr;
+    }
+    close(fd);
+
+    if (!map) {
+        fprintf(stderr, "[checkpoint] error | cannot read '%s', starting without it\n", t_path);
+        return nullptr;
+    }
+
+    uint32_t version;
+    uint64_t count;
+    memcpy(&version, map + 4, sizeof(version));
+    memcpy(&count, map + 8, sizeof(count));
+    if (memcmp(map, CKPT_MAGIC, 4) != 0 || version != CKPT_VERSION ||
+        count > (uint64_t)(file_stat.st_size - CKPT_HEADER) / CKPT_ENTRY) {
+        fprintf(stderr, "[checkpoint] error | '%s' is not a checkpoint file, starting without it\n", t_path);
+        munmap(map, file_stat.st_size);
+        return nullptr;
+    }
+
+    *t_len = file_stat.st_size;
+    *t_count = count;
+
+    return map;
+}
+
+tail_checkpoint* ckpt_open(const char* t_path, const std::vector<std::string>& t_files, ckpt_summary* t_summary) {
+    memset(t_summary, 0, sizeof(*t_summary));
+
+    // previous entries by path hash
+    size_t old_len, old_count;
+    char* old_map = map_previous(t_path, &old_len, &old_count);
+
+    std::unordered_map<uint64_t, size_t> old_entries;
+    old_entries.reserve(old_count);
+    for (size_t i = 0; i < old_count; i++)
+        old_entries[entry_at(old_map, i)->path_hash] = i;
+
+    // the new checkpoint goes next to the old one and replaces it by rename,
+    // so a crash while starting leaves one or the other
+    std::string temp_path = std::string(t_path) + ".tmp";
+    int fd = open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    size_t map_len = CKPT_HEADER + t_files.size() * CKPT_ENTRY;
+    if (fd < 0 || ftruncate(fd, map_len) != 0) {
+        fprintf(stderr, "[checkpoint] error | cannot create '%s': %s\n", temp_path.c_str(), strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        if (old_map)
+            munmap(old_map, old_len);
+        return nullptr;
+    }
+
+    char* map = (char*)mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "[checkpoint] error | cannot map '%s': %s\n", temp_path.c_str(), strerror(errno));
+        close(fd);
+        unlink(temp_path.c_str());
+        if (old_map)
+            munmap(old_map, old_len);
+        return nullptr;
+    }
+
+    uint32_t version = CKPT_VERSION;
+    uint64_t count = t_files.size();
+    memcpy(map, CKPT_MAGIC, 4);
+    memcpy(map + 4, &version, sizeof(version));
+    memcpy(map + 8, &count, sizeof(count));
+
+    for (size_t i = 0; i < t_files.size(); i++) {
+        const std::string& path = t_files[i];
+        ckpt_entry* entry = entry_at(map, i);
+
+        entry->path_hash = path_hash(path);
+        entry->path_len = (uint32_t)path.size();
+        strncpy(entry->path, path.c_str(), CKPT_PATH - 1);
+
+        struct stat file_stat;
+        if (stat(path.c_str(), &file_stat) != 0)
+            memset(&file_stat, 0, sizeof(file_stat)); // the monitor reports it
+
+        // a new file starts at its current end, like without a checkpoint
+        off_t offset = file_stat.st_size;
+        uint64_t fingerprint = 0;
+
+        std::unordered_map<uint64_t, size_t>::iterator found = old_entries.find(entry->path_hash);
+        if (found == old_entries.end()) {
+            t_summary->added++;
+        } else {
+            const ckpt_entry* old_entry = entry_at(old_map, found->second);
+            dev_t dev;
+            ino_t ino;
+            off_t old_offset;
+            uint64_t old_fingerprint;
+
+            if (old_entry->path_len != entry->path_len || strncmp(old_entry->path, entry->path, CKPT_PATH) != 0 ||
+                !ckpt_load(old_entry, &dev, &ino, &old_offset, &old_fingerprint)) {
+                // hash collision or torn entry
+                t_summary->added++;
+            } else if (dev == file_stat.st_dev && ino == file_stat.st_ino && old_offset <= file_stat.st_size &&
+                       ckpt_fingerprint(path.c_str(), old_offset) == old_fingerprint) {
+                offset = old_offset;
+                fingerprint = old_fingerprint;
+                t_summary->resumed++;
+            } else {
+                // another inode at the path (rotated), or the same one shorter
+                // or rewritten before the offset (truncated)
+                offset = 0;
+                t_summary->restarted++;
+            }
+        }
+
+        if (offset == file_stat.st_size)
+            fingerprint = ckpt_fingerprint(path.c_str(), offset);
+        ckpt_store(entry, file_stat.st_dev, file_stat.st_ino, offset, fingerprint);
+    }
+
+    if (old_map)
+        munmap(old_map, old_len);
+
+    if (msync(map, map_len, MS_SYNC) != 0 || fsync(fd) != 0 || rename(temp_path.c_str(), t_path) != 0) {
+        fprintf(stderr, "[checkpoint] error | cannot write '%s': %s\n", t_path, strerror(errno));
+        munmap(map, map_len);
+        close(fd);
+        unlink(temp_path.c_str());
+        return nullptr;
+    }
+
+    tail_checkpoint* checkpoint = new tail_checkpoint;
+    checkpoint->fd = fd;
+    checkpoint->map = map;
+    checkpoint->map_len = map_len;
+    checkpoint->count = t_files.size();
+
+    return checkpoint;
+}
+
+ckpt_entry* ckpt_get(tail_checkpoint* t_checkpoint, size_t t_index) {
+    return entry_at(t_checkpoint->map, t_index);
+}
+
+void ckpt_close(tail_checkpoint* t_checkpoint) {
+    msync(t_checkpoint->map, t_checkpoint->map_len, MS_SYNC);
+    munmap(t_checkpoint->map, t_checkpoint->map_len);
+    close(t_checkpoint->fd);
+
+    delete t_checkpoint;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// persistent read offsets of the monitored files ('tail -c file')
+//
+//   header   "TCK1", uint32 version, uint64 entry count, padding to 64 bytes
+//   entry    one per file, CKPT_ENTRY bytes: seqlock word, path hash,
+//            device, inode, offset, fingerprint of the CKPT_TAIL bytes
+//            before the offset and the path (truncated if longer)
+//
+// the file is mapped shared by the parent before forking; each monitor then
+// updates the entries of its own files in place under the entry's seqlock,
+// so the offsets on disk are always a consistent (dev, ino, offset) triple
+// even if a monitor dies half way. the fingerprint tells a file that was
+// truncated and written past the old offset while tail was not running
+
+#define CKPT_MAGIC   "TCK1"
+#define CKPT_VERSION 1
+#define CKPT_HEADER  64
+#define CKPT_ENTRY   256
+#define CKPT_PATH    (CKPT_ENTRY - 48)
+#define CKPT_TAIL    64 // bytes before the offset in the fingerprint
+
+struct ckpt_entry {
+    std::atomic<uint32_t> seq;       // odd while an update is in progress
+    uint32_t              path_len;
+    uint64_t              path_hash;
+    std::atomic<uint64_t> dev;
+    std::atomic<uint64_t> ino;
+    std::atomic<int64_t>  offset;
+    std::atomic<uint64_t> fingerprint;
+    char                  path[CKPT_PATH];
+};
+
+static_assert(sizeof(ckpt_entry) == CKPT_ENTRY, "checkpoint entry layout");
+
+struct tail_checkpoint;
+
+// what the loaded checkpoint said about the files of this run
+struct ckpt_summary {
+    size_t resumed;   // same file, continue at the saved offset
+    size_t restarted; // rotated or truncated while not running, from offset 0
+    size_t added;     // not in the checkpoint, from the current end
+};
+
+// read the previous checkpoint (if any), decide where each of t_files resumes
+// and replace it by one with an entry per file, in the order of t_files;
+// one pass over both, a hash lookup per file. returns nullptr on error
+tail_checkpoint* ckpt_open(const char* t_path, const std::vector<std::string>& t_files, ckpt_summary* t_summary);
+
+// entry of t_files[t_index]
+ckpt_entry* ckpt_get(tail_checkpoint* t_checkpoint, size_t t_index);
+
+// seqlock reader and writer; ckpt_load returns false for a torn entry
+bool ckpt_load(const ckpt_entry* t_entry, dev_t* t_dev, ino_t* t_ino, off_t* t_offset, uint64_t* t_fingerprint);
+void ckpt_store(ckpt_entry* t_entry, dev_t t_dev, ino_t t_ino, off_t t_offset, uint64_t t_fingerprint);
+
+// hash of the CKPT_TAIL bytes of the file before t_offset, 0 at offset 0;
+// of the file at t_path, of the open t_fd, or of the bytes before t_end that
+// is at t_offset in the file (a mapping of it)
+uint64_t ckpt_fingerprint(const char* t_path, off_t t_offset);
+uint64_t ckpt_fingerprint_fd(int t_fd, off_t t_offset);
+uint64_t ckpt_fingerprint_data(const char* t_end, off_t t_offset);
+
+// flush to disk and unmap
+void ckpt_close(tail_checkpoint* t_checkpoint);
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATCH_X86 1
+#endif
+
+#include "tailmatch.h"
+
+#define MATCH_BUCKETS 8
+#define MATCH_PREFIX  3 // pattern bytes in the masks at most
+
+struct tail_matcher {
+    int                      prefix; // bytes in the masks, up to the shortest pattern
+    uint8_t                  lo[MATCH_PREFIX][16]; // buckets by low nibble of byte k
+    uint8_t                  hi[MATCH_PREFIX][16]; // buckets by high nibble of byte k
+    std::vector<std::string> patterns;
+    std::vector<size_t>      buckets[MATCH_BUCKETS]; // pattern indexes sorted by prefix
+    std::vector<uint64_t>    prefixes; // bit per prefix value some pattern starts with
+    bool                     simd;
+};
+
+// the first t_prefix bytes as a number, an index of the prefixes bitmap
+static inline uint32_t prefix_key(const char* t_at, int t_prefix) {
+    uint32_t key = 0;
+    for (int k = 0; k < t_prefix; k++)
+        key = (key << 8) | (uint8_t)t_at[k];
+
+    return key;
+}
+
+tail_matcher* matcher_create(const std::vector<std::string>& t_patterns) {
+    if (t_patterns.empty())
+        return nullptr;
+
+    tail_matcher* matcher = new tail_matcher;
+    matcher->prefix = MATCH_PREFIX;
+    for (size_t i = 0; i < t_patterns.size(); i++) {
+        if (t_patterns[i].empty()) {
+            delete matcher;
+            return nullptr;
+        }
+        if ((int)t_patterns[i].size() < matcher->prefix)
+            matcher->prefix = (int)t_patterns[i].size();
+    }
+
+    memset(matcher->lo, 0, sizeof(matcher->lo));
+    memset(matcher->hi, 0, sizeof(matcher->hi));
+    matcher->patterns = t_patterns;
+
+    // patterns in order of their prefix, cut into runs of about equal size;
+    // a run never ends inside a group of equal prefixes
+    int prefix = matcher->prefix;
+    matcher->prefixes.assign(((size_t)1 << (8 * prefix)) / 64 + 1, 0);
+    std::vector<size_t> order(t_patterns.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return t_patterns[a].compare(0, prefix, t_patterns[b], 0, prefix) < 0;
+    });
+
+    size_t per_bucket = (order.size() + MATCH_BUCKETS - 1) / MATCH_BUCKETS;
+    int bucket = 0;
+    for (size_t n = 0; n < order.size(); n++) {
+        size_t i = order[n];
+        bool new_prefix = n == 0 || t_patterns[order[n - 1]].compare(0, prefix, t_patterns[i], 0, prefix) != 0;
+        if (new_prefix && matcher->buckets[bucket].size() >= per_bucket && bucket + 1 < MATCH_BUCKETS)
+            bucket++;
+        matcher->buckets[bucket].push_back(i);
+
+        uint32_t key = prefix_key(t_patterns[i].data(), prefix);
+        matcher->prefixes[key / 64] |= 1ULL << (key % 64);
+
+        // a candidate names the buckets whose prefixes fit every nibble
+        for (int k = 0; k < prefix; k++) {
+            uint8_t byte = (uint8_t)t_patterns[i][k];
+            matcher->lo[k][byte & 0x0f] |= (uint8_t)(1 << bucket);
+            matcher->hi[k][byte >> 4] |= (uint8_t)(1 << bucket);
+        }
+    }
+
+#ifdef MATCH_X86
+    matcher->simd = __builtin_cpu_supports("ssse3");
+#else
+    matcher->simd = false;
+#endif
+
+    return matcher;
+}
+
+void matcher_destroy(tail_matcher* t_matcher) {
+    delete t_matcher;
+}
+
+// ----------------------------------------------------------------------------
+
+// does a pattern of the t_bits buckets start at t_at; the caller has the
+// prefix bytes at t_at
+static bool verify(const tail_matcher* t_matcher, const char* t_at, const char* t_end, unsigned t_bits) {
+    size_t avail = t_end - t_at;
+    int prefix = t_matcher->prefix;
+    const std::vector<std::string>& patterns = t_matcher->patterns;
+
+    // with many patterns the nibble masks let most positions through; no
+    // pattern with this very prefix rules them out with one load
+    uint32_t key = prefix_key(t_at, prefix);
+    if (!(t_matcher->prefixes[key / 64] & (1ULL << (key % 64))))
+        return false;
+
+    for (int bucket = 0; bucket < MATCH_BUCKETS; bucket++) {
+        if (!(t_bits & (1u << bucket)))
+            continue;
+
+        // the patterns with the prefix at t_at, if any
+        const std::vector<size_t>& members = t_matcher->buckets[bucket];
+        auto member = std::lower_bound(members.begin(), members.end(), t_at, [&](size_t i, const char* at) {
+            return memcmp(patterns[i].data(), at, prefix) < 0;
+        });
+
+        for (; member != members.end() && memcmp(patterns[*member].data(), t_at, prefix) == 0; ++member) {
+            const std::string& pattern = patterns[*member];
+            if (pattern.size() <= avail && memcmp(t_at + prefix, pattern.data() + prefix, pattern.size() - prefix) == 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* find_scalar(const tail_matcher* t_matcher, const char* t_begin, const char* t_end) {
+    for (const char* at = t_begin; at + t_matcher->prefix <= t_end; at++) {
+        unsigned bits = 0xff;
+        for (int k = 0; k < t_matcher->prefix && bits; k++) {
+            uint8_t byte = (uint8_t)at[k];
+            bits &= t_matcher->lo[k][byte & 0x0f] & t_matcher->hi[k][byte >> 4];
+        }
+
+        if (bits && verify(t_matcher, at, t_end, bits))
+            return at;
+    }
+
+    return nullptr;
+}
+
+#ifdef MATCH_X86
+// 16 start positions per round: byte j of the result holds the buckets whose
+// prefix matches at j, one unaligned load per prefix byte
+__attribute__((target("ssse3")))
+static const char* find_ssse3(const tail_matcher* t_matcher, const char* t_begin, const char* t_end) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+    int prefix = t_matcher->prefix;
+
+    __m128i lo[MATCH_PREFIX], hi[MATCH_PREFIX];
+    for (int k = 0; k < prefix; k++) {
+        lo[k] = _mm_loadu_si128((const __m128i*)t_matcher->lo[k]);
+        hi[k] = _mm_loadu_si128((const __m128i*)t_matcher->hi[k]);
+    }
+
+    const char* at = t_begin;
+    while (t_end - at >= 16 + prefix - 1) {
+        __m128i buckets = _mm_set1_epi8(-1);
+        for (int k = 0; k < prefix; k++) {
+            __m128i input = _mm_loadu_si128((const __m128i*)(at + k));
+            __m128i low = _mm_shuffle_epi8(lo[k], _mm_and_si128(input, nibble));
+            __m128i high = _mm_shuffle_epi8(hi[k], _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+            buckets = _mm_and_si128(buckets, _mm_and_si128(low, high));
+        }
+
+        unsigned candidates = ~_mm_movemask_epi8(_mm_cmpeq_epi8(buckets, zero)) & 0xffff;
+        if (candidates) {
+            uint8_t bits[16];
+            _mm_storeu_si128((__m128i*)bits, buckets);
+
+            for (; candidates; candidates &= candidates - 1) {
+                int j = __builtin_ctz(candidates);
+                if (verify(t_matcher, at + j, t_end, bits[j]))
+                    return at + j;
+            }
+        }
+
+        at += 16;
+    }
+
+    return find_scalar(t_matcher, at, t_end);
+}
+#endif
+
+const char* matcher_find(const tail_matcher* t_matcher, const char* t_begin, const char* t_end) {
+#ifdef MATCH_X86
+    if (t_matcher->simd)
+        return find_ssse3(t_matcher, t_begin, t_end);
+#endif
+    return find_scalar(t_matcher, t_begin, t_end);
+}
+
+// ----------------------------------------------------------------------------
+
+bool matcher_read_patterns(const char* t_path, std::vector<std::string>& t_patterns) {
+    FILE* fp = fopen(t_path, "r");
+    if (!fp)
+        return false;
+
+    char* line = nullptr;
+    size_t capacity = 0;
+    ssize_t len;
+    while ((len = getline(&line, &capacity, fp)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            len--;
+        if (len > 0)
+            t_patterns.push_back(std::string(line, len));
+    }
+
+    free(line);
+    fclose(fp);
+
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// multi-literal matcher for the line filter ('tail -e PATTERN', '-f file')
+//
+// a Teddy style prefilter: the patterns are spread over 8 buckets and the
+// first 1..3 bytes of every pattern are folded into per-position nibble masks,
+// so 16 input bytes are tested against all patterns with a few pshufb/and.
+// patterns are sorted by prefix and cut into 8 runs, so the ones sharing a
+// prefix share a bucket and its masks stay narrow; a candidate is confirmed
+// by a binary search for its prefix in the sorted buckets it names and a
+// compare of only the patterns with that prefix, after a bitmap of the
+// prefixes has ruled out most false candidates. without SSSE3 the same
+// tables are walked byte by byte
+
+struct tail_matcher;
+
+// nullptr if there is no pattern or one is empty
+tail_matcher* matcher_create(const std::vector<std::string>& t_patterns);
+void matcher_destroy(tail_matcher* t_matcher);
+
+// first byte in [t_begin, t_end) where any pattern starts, or nullptr
+const char* matcher_find(const tail_matcher* t_matcher, const char* t_begin, const char* t_end);
+
+// patterns of a -f file, one per line; empty lines are skipped. false if it
+// cannot be read
+bool matcher_read_patterns(const char* t_path, std::vector<std::string>& t_patterns);
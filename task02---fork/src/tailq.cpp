@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "tailbin.h"
+
+// query the binary log of 'tail --format=bin -l base': the records of a time
+// range, found by binary search over the segments and their indexes
+
+#define TAILQ_ALL UINT64_MAX
+
+// "YYYY-MM-DD HH:MM:SS" (or with a T) in local time, or "@seconds" since the
+// epoch; 0 if it is neither
+uint64_t parse_time(const char* t_text) {
+    if (t_text[0] == '@') {
+        char* end;
+        double seconds = strtod(t_text + 1, &end);
+        return (*end == '\0' && seconds >= 0) ? (uint64_t)(seconds * 1e9) : 0;
+    }
+
+    struct tm fields;
+    memset(&fields, 0, sizeof(fields));
+    const char* end = strptime(t_text, "%Y-%m-%d %H:%M:%S", &fields);
+    if (!end) {
+        end = strptime(t_text, "%Y-%m-%dT%H:%M:%S", &fields);
+    }
+    if (!end || *end != '\0') {
+        return 0;
+    }
+
+    fields.tm_isdst = -1;
+    time_t seconds = mktime(&fields);
+    return (seconds < 0) ? 0 : (uint64_t)seconds * 1000000000ULL;
+}
+
+void print_record(const bin_record* t_record, const char* t_payload, const std::vector<std::string>& t_files) {
+    time_t seconds = (time_t)(t_record->timestamp / 1000000000ULL);
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    char time_str[32];
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+    if (t_record->kind == TAILBIN_CHANGE) {
+        const char* path = (t_record->file_id < t_files.size()) ? t_files[t_record->file_id].c_str() : "?";
+        printf("%s.%06lu [%d] '%s' grew from %ld to %ld bytes\n", time_str,
+               (unsigned long)(t_record->timestamp % 1000000000ULL / 1000), t_record->pid, path,
+               (long)t_record->old_size, (long)t_record->new_size);
+    } else {
+        printf("%s.%06lu %.*s\n", time_str, (unsigned long)(t_record->timestamp % 1000000000ULL / 1000),
+               (int)t_record->payload_len, t_payload);
+    }
+}
+
+int main(int argc, char** argv) {
+    // ------------------------------------------------------------------------
+    // parse arguments
+    // ------------------------------------------------------------------------
+    uint64_t since = 0;
+    uint64_t until = TAILQ_ALL;
+    const char* only_file = nullptr;
+    bool count_only = false;
+    int arg = 1;
+
+    while (arg < argc) {
+        if ((strcmp(argv[arg], "-s") == 0 || strcmp(argv[arg], "-u") == 0) && arg + 1 < argc) {
+            uint64_t time = parse_time(argv[arg + 1]);
+            if (!time) {
+                fprintf(stderr, "[error] invalid time '%s'\n", argv[arg + 1]);
+                return EXIT_FAILURE;
+            }
+            if (argv[arg][1] == 's') {
+                since = time;
+            } else if (strchr(argv[arg + 1], '.')) {
+                until = time;
+            } else {
+                // a whole second takes in all of its records
+                until = time + 999999999ULL;
+            }
+            arg += 2;
+        } else if (strcmp(argv[arg], "-f") == 0 && arg + 1 < argc) {
+            only_file = argv[arg + 1];
+            arg += 2;
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            count_only = true;
+            arg++;
+        } else {
+            break;
+        }
+    }
+
+    if (arg + 1 != argc) {
+        fprintf(stderr, "usage: %s [-s since] [-u until] [-f file] [-c] <logfile>\n", argv[0]);
+        fprintf(stderr, "  -s  records at or after this time: 'YYYY-MM-DD HH:MM:SS' (local) or @seconds\n");
+        fprintf(stderr, "  -u  records at or before this time, same forms; a whole second includes all of it\n");
+        fprintf(stderr, "  -f  only the records about this file (path as given to tail)\n");
+        fprintf(stderr, "  -c  count the records instead of printing them\n");
+        fprintf(stderr, "example: %s -s '2025-01-31 12:00:00' -u '2025-01-31 12:05:00' logs/tail\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* base = argv[arg];
+
+    std::vector<bin_segment> segments = bin_segments(base);
+    if (segments.empty()) {
+        fprintf(stderr, "[error] no segments '%s.NNNNNN.tlb'\n", base);
+        return EXIT_FAILURE;
+    }
+
+    // ------------------------------------------------------------------------
+    // the last segment starting at or before 'since', then its index
+    // ------------------------------------------------------------------------
+    size_t low = 0;
+    size_t high = segments.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (segments[middle].first <= since) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    size_t first = (low > 0) ? low - 1 : 0;
+
+    unsigned long matched = 0;
+    unsigned long scanned = 0;
+    size_t read_segments = 0;
+    bool done = false;
+
+    for (size_t i = first; i < segments.size() && !done; i++) {
+        if (segments[i].first > until) {
+            break;
+        }
+
+        int fd = open(segments[i].path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat segment_stat;
+        if (fd < 0 || fstat(fd, &segment_stat) != 0 || segment_stat.st_size <= TAILBIN_HEADER) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+        size_t size = segment_stat.st_size;
+        char* map = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "[error] cannot map '%s'\n", segments[i].path.c_str());
+            continue;
+        }
+        read_segments++;
+
+        // the file table at the start of the segment
+        std::vector<std::string> files;
+        size_t offset = TAILBIN_HEADER;
+        while (offset + sizeof(bin_record) <= size) {
+            const bin_record* record = (const bin_record*)(map + offset);
+            if (record->kind != TAILBIN_FILE || offset + TAILBIN_RECORD(record->payload_len) > size) {
+                break;
+            }
+            if (record->file_id >= files.size()) {
+                files.resize(record->file_id + 1);
+            }
+            files[record->file_id].assign(map + offset + sizeof(bin_record), record->payload_len);
+            offset += TAILBIN_RECORD(record->payload_len);
+        }
+
+        // only the first segment can start before the range
+        if (i == first && since > 0) {
+            uint64_t start = bin_seek(segments[i], since);
+            if (start > offset && start < size) {
+                offset = start;
+            }
+        }
+
+        // records in order of time; a partly written one ends the segment
+        while (offset + sizeof(bin_record) <= size) {
+            const bin_record* record = (const bin_record*)(map + offset);
+            size_t len = TAILBIN_RECORD(record->payload_len);
+            if (offset + len > size) {
+                break;
+            }
+            offset += len;
+            scanned++;
+
+            if (record->timestamp > until) {
+                done = true;
+                break;
+            }
+            if (record->timestamp < since || record->kind == TAILBIN_FILE) {
+                continue;
+            }
+            if (only_file && (record->file_id >= files.size() || files[record->file_id] != only_file)) {
+                continue;
+            }
+
+            matched++;
+            if (!count_only) {
+                print_record(record, (const char*)(record + 1), files);
+            }
+        }
+
+        munmap(map, size);
+    }
+
+    if (count_only) {
+        printf("%lu\n", matched);
+    }
+    fprintf(stderr, "[tailq] info | %lu record(s) in range; %lu scanned in %lu of %lu segment(s)\n",
+            matched, scanned, read_segments, segments.size());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <atomic>
+#include <new>
+
+#include "tailring.h"
+
+#define RECORD_EMPTY 0
+#define RECORD_DATA  1
+#define RECORD_PAD   2
+
+#define RING_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+// waits for space give up after this long and look again, in case a wakeup
+// went to a process that died
+#define RING_SPACE_WAIT_MS 100
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(int), "futex word must be an int");
+
+struct ring_record {
+    uint32_t              length; // payload bytes; whole record size for padding
+    std::atomic<uint32_t> state;  // RECORD_*, published last
+};
+
+// the header lives in the mapping in front of the data; head and tail are on
+// their own cache lines since producers and the consumer write them
+struct tail_ring {
+    size_t                capacity;
+    size_t                mask;
+    alignas(64) std::atomic<uint64_t> head; // reserved up to, by the producers
+    std::atomic<uint32_t> space_seq;        // bumped when space frees up
+    std::atomic<uint32_t> producers_waiting;
+    alignas(64) std::atomic<uint64_t> tail; // released up to, by the consumer
+    std::atomic<uint32_t> data_seq;         // bumped when a record is ready
+    std::atomic<uint32_t> consumer_waiting;
+    std::atomic<uint32_t> closed;
+};
+
+// ----------------------------------------------------------------------------
+
+// not FUTEX_PRIVATE_FLAG: the word is shared between processes
+static void futex_wait(std::atomic<uint32_t>* t_word, uint32_t t_value, int t_timeout_ms) {
+    struct timespec timeout = { t_timeout_ms / 1000, (t_timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, (int*)t_word, FUTEX_WAIT, t_value, t_timeout_ms >= 0 ? &timeout : NULL, NULL, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* t_word, int t_count) {
+    syscall(SYS_futex, (int*)t_word, FUTEX_WAKE, t_count, NULL, NULL, 0);
+}
+
+static inline char* ring_data(tail_ring* t_ring) {
+    return (char*)(t_ring + 1);
+}
+
+static inline ring_record* ring_at(tail_ring* t_ring, uint64_t t_position) {
+    return (ring_record*)(ring_data(t_ring) + (t_position & t_ring->mask));
+}
+
+// ----------------------------------------------------------------------------
+
+tail_ring* ring_create(size_t t_capacity) {
+    size_t capacity = 4096;
+    while (capacity < t_capacity)
+        capacity <<= 1;
+
+    void* memory = mmap(NULL, sizeof(tail_ring) + capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return nullptr;
+
+    // the data area starts zeroed, i.e. all records empty
+    tail_ring* ring = new (memory) tail_ring();
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+
+    return ring;
+}
+
+void ring_destroy(tail_ring* t_ring) {
+    munmap(t_ring, sizeof(tail_ring) + t_ring->capacity);
+}
+
+// ----------------------------------------------------------------------------
+// producers
+
+static void wait_for_space(tail_ring* t_ring, uint64_t t_tail) {
+    t_ring->producers_waiting.fetch_add(1);
+    uint32_t seq = t_ring->space_seq.load();
+    if (t_ring->tail.load() == t_tail && !t_ring->closed.load())
+        futex_wait(&t_ring->space_seq, seq, RING_SPACE_WAIT_MS);
+    t_ring->producers_waiting.fetch_sub(1);
+}
+
+static bool ring_put(tail_ring* t_ring, const void* t_data, size_t t_len) {
+    size_t need = RING_ALIGN(sizeof(ring_record) + t_len);
+    uint64_t head = t_ring->head.load(std::memory_order_relaxed);
+    size_t pad;
+
+    // reserve the record (and the rest of the ring if it does not fit before the wrap)
+    while (true) {
+        if (t_ring->closed.load(std::memory_order_acquire))
+            return false;
+
+        size_t position = head & t_ring->mask;
+        pad = (position + need > t_ring->capacity) ? t_ring->capacity - position : 0;
+
+        uint64_t tail = t_ring->tail.load(std::memory_order_acquire);
+        if (head + pad + need - tail > t_ring->capacity) {
+            wait_for_space(t_ring, tail);
+            head = t_ring->head.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (t_ring->head.compare_exchange_weak(head, head + pad + need, std::memory_order_acq_rel, std::memory_order_relaxed))
+            break;
+    }
+
+    if (pad) {
+        ring_record* filler = ring_at(t_ring, head);
+        filler->length = (uint32_t)pad;
+        filler->state.store(RECORD_PAD);
+        head += pad;
+    }
+
+    ring_record* record = ring_at(t_ring, head);
+    record->length = (uint32_t)t_len;
+    memcpy((char*)(record + 1), t_data, t_len);
+    record->state.store(RECORD_DATA);
+
+    // the logger only needs a syscall when it sleeps
+    if (t_ring->consumer_waiting.load()) {
+        t_ring->data_seq.fetch_add(1);
+        futex_wake(&t_ring->data_seq, 1);
+    }
+
+    return true;
+}
+
+bool ring_write(tail_ring* t_ring, const void* t_data, size_t t_len) {
+    // a record must leave room for others; the rare longer message is split
+    size_t max_record = t_ring->capacity / 4 - sizeof(ring_record);
+    const char* data = (const char*)t_data;
+
+    do {
+        size_t part = (t_len > max_record) ? max_record : t_len;
+        if (!ring_put(t_ring, data, part))
+            return false;
+
+        data += part;
+        t_len -= part;
+    } while (t_len > 0);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// consumer
+
+int ring_read(tail_ring* t_ring, struct iovec* t_iov, int t_max, size_t* t_bytes) {
+    while (true) {
+        uint64_t tail = t_ring->tail.load(std::memory_order_relaxed);
+        size_t consumed = 0;
+        int count = 0;
+
+        // the ready records in a row from the tail
+        while (count < t_max && consumed < t_ring->capacity) {
+            ring_record* record = ring_at(t_ring, tail + consumed);
+            uint32_t state = record->state.load();
+            if (state == RECORD_EMPTY)
+                break;
+
+            if (state == RECORD_PAD) {
+                consumed += record->length;
+                continue;
+            }
+
+            t_iov[count].iov_base = record + 1;
+            t_iov[count].iov_len = record->length;
+            count++;
+            consumed += RING_ALIGN(sizeof(ring_record) + record->length);
+        }
+
+        if (count > 0) {
+            *t_bytes = consumed;
+            return count;
+        }
+        if (consumed > 0) {
+            // padding only
+            ring_release(t_ring, consumed);
+            continue;
+        }
+
+        // empty; everybody has stopped writing once the ring is closed
+        if (t_ring->closed.load())
+            return 0;
+
+        t_ring->consumer_waiting.store(1);
+        uint32_t seq = t_ring->data_seq.load();
+        if (ring_at(t_ring, tail)->state.load() == RECORD_EMPTY && !t_ring->closed.load())
+            futex_wait(&t_ring->data_seq, seq, -1);
+        t_ring->consumer_waiting.store(0);
+    }
+}
+
+void ring_release(tail_ring* t_ring, size_t t_bytes) {
+    uint64_t tail = t_ring->tail.load(std::memory_order_relaxed);
+
+    // free space must read as empty records wherever the next headers land
+    size_t position = tail & t_ring->mask;
+    size_t first = (position + t_bytes > t_ring->capacity) ? t_ring->capacity - position : t_bytes;
+    memset(ring_data(t_ring) + position, 0, first);
+    memset(ring_data(t_ring), 0, t_bytes - first);
+
+    t_ring->tail.store(tail + t_bytes);
+
+    if (t_ring->producers_waiting.load()) {
+        t_ring->space_seq.fetch_add(1);
+        futex_wake(&t_ring->space_seq, INT_MAX);
+    }
+}
+
+void ring_close(tail_ring* t_ring) {
+    t_ring->closed.store(1);
+
+    t_ring->data_seq.fetch_add(1);
+    futex_wake(&t_ring->data_seq, 1);
+    t_ring->space_seq.fetch_add(1);
+    futex_wake(&t_ring->space_seq, INT_MAX);
+}
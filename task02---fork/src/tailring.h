@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+// multi-producer single-consumer ring of log records in shared memory
+//
+// the ring is created by the parent before forking, so the monitors
+// (producers) and the logger (consumer) share it. every record is written
+// whole into its own reserved space, so records of different monitors never
+// interleave whatever their size; a futex wakes the logger when it sleeps on
+// an empty ring and the monitors when they wait for space
+//
+//   record   uint32 length, uint32 state (empty/data/padding), payload
+//            padded to 8 bytes; a padding record fills the end of the ring
+//            when the next record does not fit before the wrap
+
+#define RING_SIZE (1 << 20) // default capacity, bytes
+#define RING_IOV  64        // records per logger batch
+
+struct tail_ring;
+
+// shared anonymous mapping; t_capacity is rounded up to a power of two
+tail_ring* ring_create(size_t t_capacity);
+void ring_destroy(tail_ring* t_ring);
+
+// producer: append one message (longer ones are split into several records);
+// waits while the ring is full; returns false once the ring is closed
+bool ring_write(tail_ring* t_ring, const void* t_data, size_t t_len);
+
+// consumer: wait for records and point t_iov at the payloads of up to t_max
+// of them, in order; t_bytes receives the ring space they occupy for
+// ring_release; returns the count, 0 when closed and drained
+int ring_read(tail_ring* t_ring, struct iovec* t_iov, int t_max, size_t* t_bytes);
+void ring_release(tail_ring* t_ring, size_t t_bytes);
+
+// no more records; wakes everybody, the consumer still drains the ring
+void ring_close(tail_ring* t_ring);
@@ -0,0 +1,87 @@
+#!/bin/bash
+# script for testing tail -c: resume, rotation and truncation
+
+cd "$(dirname "$0")"
+
+FAILED=0
+
+# clean up
+rm -f stop ckpt_file.txt ckpt_file.txt.1 ckpt_test.ckpt ckpt_test.log ckpt_out.txt
+
+# start tail in background, raw content into ckpt_out.txt
+start_tail() {
+    rm -f stop
+    ./tail -r -c ckpt_test.ckpt -l ckpt_test.log ckpt_file.txt > ckpt_out.txt 2> /dev/null &
+    TAIL_PID=$!
+    sleep 1
+}
+
+stop_tail() {
+    touch stop
+    wait $TAIL_PID 2>/dev/null
+    rm -f stop
+}
+
+# expected content of ckpt_out.txt
+expect() {
+    if [ "$(cat ckpt_out.txt)" == "$2" ]; then
+        echo "+++ [test] PASS: $1"
+    else
+        echo "+++ [test] FAIL: $1"
+        echo "    expected: '$2'"
+        echo "    got:      '$(cat ckpt_out.txt)'"
+        FAILED=1
+    fi
+}
+
+echo "+++ [test] creating test file"
+printf 'hello world\n' > ckpt_file.txt
+
+echo "+++ [test] truncated and appended to while running (copytruncate)"
+start_tail
+: > ckpt_file.txt; printf 'TRUNCATED-AND-LONGER-LINE\n' >> ckpt_file.txt
+sleep 1
+stop_tail
+expect "copytruncate while running" "TRUNCATED-AND-LONGER-LINE"
+
+echo "+++ [test] appended to while not running (resume)"
+printf 'line while stopped\n' >> ckpt_file.txt
+start_tail
+stop_tail
+expect "resume at the saved offset" "line while stopped"
+
+echo "+++ [test] truncated and appended to while not running"
+printf 'rewritten while stopped, longer than before\n' > ckpt_file.txt
+start_tail
+stop_tail
+expect "copytruncate while stopped" "rewritten while stopped, longer than before"
+
+echo "+++ [test] rotated while not running"
+mv ckpt_file.txt ckpt_file.txt.1
+printf 'rotated while stopped\n' > ckpt_file.txt
+start_tail
+stop_tail
+expect "rotation while stopped" "rotated while stopped"
+
+echo "+++ [test] rotated while running"
+start_tail
+mv ckpt_file.txt ckpt_file.txt.1
+printf 'rotated while running\n' > ckpt_file.txt
+sleep 1
+stop_tail
+expect "rotation while running" "rotated while running"
+
+echo "+++ [test] truncated while running"
+start_tail
+: > ckpt_file.txt
+sleep 1
+printf 'short\n' >> ckpt_file.txt
+sleep 1
+stop_tail
+expect "truncation while running" "short"
+
+echo "+++ [test] cleaning up"
+rm -f stop ckpt_file.txt ckpt_file.txt.1 ckpt_test.ckpt ckpt_test.log ckpt_out.txt
+
+echo "+++ [test] done"
+exit $FAILED
@@ -26,10 +26,19 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <ctype.h>
+#include <pthread.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <signal.h>
 
 #define STR_CLOSE   "close"
 #define STR_QUIT    "quit"
+#define CACHE_DIR   "image_cache"   // default directory for spilled images
+#define IMAGE_FILE  "podzim.png"    // source of all resolutions
+#define SEND_TIMEOUT    30          // seconds a client may not read before it is dropped
 
 //***************************************************************************
 // log messages
@@ -80,9 +89,10 @@ void help( int t_narg, char **t_args )
             "\n"
             "  Socket server example.\n"
             "\n"
-            "  Use: %s [-h -d] port_number\n"
+            "  Use: %s [-h -d -c cache_dir] port_number\n"
             "\n"
             "    -d  debug mode \n"
+            "    -c  directory for images spilled from cache (default " CACHE_DIR ")\n"
             "    -h  this help\n"
             "\n", t_args[ 0 ] );
 
@@ -94,41 +104,479 @@ void help( int t_narg, char **t_args )
 }
 
 //***************************************************************************
-// Handle client communication in child process
+// cache of compressed images, shared by all client processes
+//
+// Every resolution is converted only once. The result is kept in one of
+// CACHE_SLOTS slots of shared memory, the least recently used slot is reused
+// for a new resolution and its image is spilled into the cache directory,
+// where the next request for it is loaded from. Results bigger than a slot
+// go to the directory only. Requests for a resolution being converted wait
+// for the conversion instead of starting their own; the owner finishes the
+// slot before it sends anything, so a slow client delays only itself. Key
+// carries mtime and size of source image, images of its older versions are
+// never served and are removed from the directory, which is kept bounded.
+// Lock is robust, process killed while holding it does not block others.
 
-void handle_client( int t_client_socket )
+#define CACHE_SLOTS             8               // images in memory
+#define CACHE_SLOT_SIZE         ( 4 << 20 )     // bytes of one image in memory
+#define CACHE_KEY_LEN           80
+#define CACHE_READERS           32              // processes sending one image at once
+#define SPILL_FILES             256             // images in cache directory
+#define SPILL_BYTES             ( 256L << 20 )  // and their bytes
+
+#define SLOT_EMPTY              0
+#define SLOT_BUSY               1               // converted or loaded by owner
+#define SLOT_READY              2
+
+struct cache_slot
 {
-    char l_buf[ 256 ];
-    
-    // Read resolution request from client
-    int l_len = read( t_client_socket, l_buf, sizeof( l_buf ) - 1 );
-    if ( l_len <= 0 )
+    char key[ CACHE_KEY_LEN ];                  // "WxH-mtime-size"
+    int state;
+    int readers;                                // processes sending the image
+    pid_t reader_pids[ CACHE_READERS ];         // their pids, 0 for free entry
+    pid_t owner;                                // of busy slot
+    size_t len;
+    unsigned long last_use;
+};
+
+struct image_cache
+{
+    pthread_mutex_t lock;
+    pthread_cond_t done;                        // some busy slot finished
+    unsigned long clock;
+    unsigned long hits, disk_hits, misses, coalesced;
+    cache_slot slots[ CACHE_SLOTS ];
+};
+
+image_cache *g_cache = nullptr;
+char *g_cache_data = nullptr;                   // CACHE_SLOTS * CACHE_SLOT_SIZE
+const char *g_cache_dir = CACHE_DIR;
+
+// "-mtime-size" of source image, end of every cache key; false without source
+bool source_stamp( char *t_stamp, size_t t_size )
+{
+    struct stat l_source;
+    if ( stat( IMAGE_FILE, &l_source ) < 0 ) return false;
+    snprintf( t_stamp, t_size, "-%ld-%ld", ( long ) l_source.st_mtime, ( long ) l_source.st_size );
+    return true;
+}
+
+struct spill_file
+{
+    char name[ 256 ];
+    timespec used;                              // mtime, renewed by every load
+    off_t size;
+};
+
+int spill_newer( const void *t_a, const void *t_b )
+{
+    const timespec *l_a = &( ( const spill_file * ) t_a )->used;
+    const timespec *l_b = &( ( const spill_file * ) t_b )->used;
+    if ( l_a->tv_sec != l_b->tv_sec ) return ( l_a->tv_sec < l_b->tv_sec ) - ( l_a->tv_sec > l_b->tv_sec );
+    return ( l_a->tv_nsec < l_b->tv_nsec ) - ( l_a->tv_nsec > l_b->tv_nsec );
+}
+
+// Keep cache directory bounded. Images of other versions of source go first,
+// then the least recently used ones above SPILL_FILES or SPILL_BYTES. The
+// most recent image always stays, it may be just written for its client.
+void spill_trim()
+{
+    char l_stamp[ 48 ], l_suffix[ 64 ];
+    if ( !source_stamp( l_stamp, sizeof( l_stamp ) ) ) return;
+    snprintf( l_suffix, sizeof( l_suffix ), "%s.xz", l_stamp );
+    size_t l_suffix_len = strlen( l_suffix );
+
+    DIR *l_dir = opendir( g_cache_dir );
+    if ( !l_dir ) return;
+
+    spill_file *l_files = nullptr;
+    int l_count = 0, l_capacity = 0;
+    char l_path[ 600 ];
+    dirent *l_entry;
+    while ( ( l_entry = readdir( l_dir ) ) )
     {
-        log_msg( LOG_ERROR, "Unable to read resolution from client." );
-        close( t_client_socket );
-        exit( 1 );
+        snprintf( l_path, sizeof( l_path ), "%s/%s", g_cache_dir, l_entry->d_name );
+
+        // temporary file "key.xz.pid" is not an image yet, unless its process is gone
+        size_t l_len = strlen( l_entry->d_name );
+        const char *l_tmp = strstr( l_entry->d_name, ".xz." );
+        if ( l_tmp )
+        {
+            pid_t l_pid = atoi( l_tmp + 4 );
+            if ( l_pid > 0 && kill( l_pid, 0 ) < 0 && errno == ESRCH )
+            {
+                log_msg( LOG_DEBUG, "Removing '%s' left by process %d.", l_path, l_pid );
+                unlink( l_path );
+            }
+            continue;
+        }
+        if ( l_len < 3 || strcmp( l_entry->d_name + l_len - 3, ".xz" ) ) continue;
+
+        if ( l_len < l_suffix_len || strcmp( l_entry->d_name + l_len - l_suffix_len, l_suffix ) )
+        {
+            log_msg( LOG_DEBUG, "Removing '%s' of older source.", l_path );
+            unlink( l_path );
+            continue;
+        }
+
+        struct stat l_stat;
+        if ( stat( l_path, &l_stat ) < 0 ) continue;
+        if ( l_count == l_capacity )
+        {
+            l_capacity = l_capacity ? 2 * l_capacity : 64;
+            l_files = ( spill_file * ) realloc( l_files, l_capacity * sizeof( spill_file ) );
+        }
+        snprintf( l_files[ l_count ].name, sizeof( l_files[ l_count ].name ), "%s", l_entry->d_name );
+        l_files[ l_count ].used = l_stat.st_mtim;
+        l_files[ l_count ].size = l_stat.st_size;
+        l_count++;
     }
-    
-    l_buf[ l_len ] = 0; // null terminate
-    
-    // Remove newline if present
-    char *newline = strchr( l_buf, '\n' );
-    if ( newline ) *newline = 0;
-    
-    log_msg( LOG_INFO, "Client requested resolution: %s", l_buf );
-    
+    closedir( l_dir );
+
+    qsort( l_files, l_count, sizeof( spill_file ), spill_newer );
+    long l_bytes = 0;
+    for ( int i = 0; i < l_count; i++ )
+    {
+        l_bytes += l_files[ i ].size;
+        if ( i > 0 && ( i >= SPILL_FILES || l_bytes > SPILL_BYTES ) )
+        {
+            snprintf( l_path, sizeof( l_path ), "%s/%s", g_cache_dir, l_files[ i ].name );
+            log_msg( LOG_DEBUG, "Removing least recently used '%s'.", l_path );
+            unlink( l_path );
+        }
+    }
+    free( l_files );
+}
+
+// shared memory for cache, it has to be created before first fork
+void cache_create()
+{
+    size_t l_size = sizeof( image_cache ) + ( size_t ) CACHE_SLOTS * CACHE_SLOT_SIZE;
+    void *l_mem = mmap( nullptr, l_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if ( l_mem == MAP_FAILED )
+    {
+        log_msg( LOG_ERROR, "Unable to map cache memory, images will not be cached." );
+        return;
+    }
+
+    if ( mkdir( g_cache_dir, 0755 ) < 0 && errno != EEXIST )
+        log_msg( LOG_ERROR, "Unable to create cache directory '%s'.", g_cache_dir );
+    spill_trim();
+
+    image_cache *l_cache = ( image_cache * ) l_mem;
+    memset( l_cache, 0, sizeof( image_cache ) );
+
+    pthread_mutexattr_t l_mattr;
+    pthread_mutexattr_init( &l_mattr );
+    pthread_mutexattr_setpshared( &l_mattr, PTHREAD_PROCESS_SHARED );
+    pthread_mutexattr_setrobust( &l_mattr, PTHREAD_MUTEX_ROBUST );
+    pthread_mutex_init( &l_cache->lock, &l_mattr );
+    pthread_mutexattr_destroy( &l_mattr );
+
+    pthread_condattr_t l_cattr;
+    pthread_condattr_init( &l_cattr );
+    pthread_condattr_setpshared( &l_cattr, PTHREAD_PROCESS_SHARED );
+    pthread_cond_init( &l_cache->done, &l_cattr );
+    pthread_condattr_destroy( &l_cattr );
+
+    g_cache = l_cache;
+    g_cache_data = ( char * ) l_mem + sizeof( image_cache );
+
+    log_msg( LOG_INFO, "Image cache: %d x %d kB in memory, spill directory '%s'.",
+             CACHE_SLOTS, CACHE_SLOT_SIZE >> 10, g_cache_dir );
+}
+
+// Owner of lock died in the middle of update. Slot it was changing is
+// released by cache_release when the parent reaps it, counters may be off.
+void cache_recover( int t_ret )
+{
+    if ( t_ret == EOWNERDEAD )
+    {
+        log_msg( LOG_INFO, "Cache lock holder terminated, lock recovered." );
+        pthread_mutex_consistent( &g_cache->lock );
+    }
+}
+
+void cache_lock()
+{
+    cache_recover( pthread_mutex_lock( &g_cache->lock ) );
+}
+
+void cache_unlock()
+{
+    pthread_mutex_unlock( &g_cache->lock );
+}
+
+// pin slot for reading by this process, false when it has too many readers
+bool cache_pin( cache_slot *t_slot )
+{
+    for ( int i = 0; i < CACHE_READERS; i++ )
+        if ( !t_slot->reader_pids[ i ] )
+        {
+            t_slot->reader_pids[ i ] = getpid();
+            t_slot->readers++;
+            return true;
+        }
+    return false;
+}
+
+char *cache_data( int t_slot )
+{
+    return g_cache_data + ( size_t ) t_slot * CACHE_SLOT_SIZE;
+}
+
+void spill_path( const char *t_key, char *t_path, size_t t_size )
+{
+    snprintf( t_path, t_size, "%s/%s.xz", g_cache_dir, t_key );
+}
+
+// write all data to socket, no SIGPIPE when client is gone
+bool send_all( int t_socket, const char *t_data, size_t t_len )
+{
+    while ( t_len > 0 )
+    {
+        ssize_t l_sent = send( t_socket, t_data, t_len, MSG_NOSIGNAL );
+        if ( l_sent < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            return false;
+        }
+        t_data += l_sent;
+        t_len -= l_sent;
+    }
+    return true;
+}
+
+bool write_all( int t_fd, const char *t_data, size_t t_len )
+{
+    while ( t_len > 0 )
+    {
+        ssize_t l_written = write( t_fd, t_data, t_len );
+        if ( l_written < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            return false;
+        }
+        t_data += l_written;
+        t_len -= l_written;
+    }
+    return true;
+}
+
+// image leaving memory goes to cache directory, unless it is already there
+void cache_spill( const char *t_key, const char *t_data, size_t t_len )
+{
+    char l_path[ 512 ], l_tmp[ 600 ];
+    spill_path( t_key, l_path, sizeof( l_path ) );
+    if ( access( l_path, F_OK ) == 0 ) return;
+
+    // temporary name first, readers never see a part of image
+    snprintf( l_tmp, sizeof( l_tmp ), "%s.%d", l_path, getpid() );
+    int l_fd = open( l_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( l_fd < 0 )
+    {
+        log_msg( LOG_ERROR, "Unable to create spill file '%s'.", l_tmp );
+        return;
+    }
+
+    bool l_ok = write_all( l_fd, t_data, t_len );
+    close( l_fd );
+    if ( !l_ok || rename( l_tmp, l_path ) < 0 )
+    {
+        log_msg( LOG_ERROR, "Unable to spill image %s to '%s'.", t_key, l_path );
+        unlink( l_tmp );
+        return;
+    }
+    log_msg( LOG_DEBUG, "Image %s spilled to '%s'.", t_key, l_path );
+    spill_trim();
+}
+
+// Find slot for key. Image in memory is pinned for reading (*t_own is false),
+// otherwise caller becomes owner of busy slot and has to fill it and call
+// cache_finish (*t_own is true). Returns -1 when no slot can be reused, or
+// the image has CACHE_READERS readers already.
+int cache_acquire( const char *t_key, bool *t_own )
+{
+    char l_old_key[ CACHE_KEY_LEN ] = "";
+    size_t l_old_len = 0;
+    bool l_waited = false;
+    int l_slot = -1;
+
+    cache_lock();
+    while ( 1 )
+    {
+        int l_found = -1;
+        for ( int i = 0; i < CACHE_SLOTS; i++ )
+            if ( g_cache->slots[ i ].state != SLOT_EMPTY && !strcmp( g_cache->slots[ i ].key, t_key ) )
+                l_found = i;
+
+        if ( l_found >= 0 && g_cache->slots[ l_found ].state == SLOT_BUSY )
+        {
+            // coalesce with conversion in progress
+            if ( !l_waited ) g_cache->coalesced++;
+            l_waited = true;
+            cache_recover( pthread_cond_wait( &g_cache->done, &g_cache->lock ) );
+            continue;
+        }
+
+        if ( l_found >= 0 )
+        {
+            cache_slot *l_hit = &g_cache->slots[ l_found ];
+            if ( !cache_pin( l_hit ) )
+                break;                          // too many readers, convert without cache
+            l_hit->last_use = ++g_cache->clock;
+            g_cache->hits++;
+            *t_own = false;
+            l_slot = l_found;
+            break;
+        }
+
+        // empty slot, or least recently used one nobody reads
+        for ( int i = 0; i < CACHE_SLOTS; i++ )
+        {
+            cache_slot *l_cand = &g_cache->slots[ i ];
+            if ( l_cand->state == SLOT_EMPTY )
+            {
+                l_slot = i;
+                break;
+            }
+            if ( l_cand->state == SLOT_READY && !l_cand->readers &&
+                 ( l_slot < 0 || l_cand->last_use < g_cache->slots[ l_slot ].last_use ) )
+                l_slot = i;
+        }
+
+        if ( l_slot >= 0 )
+        {
+            cache_slot *l_own = &g_cache->slots[ l_slot ];
+            if ( l_own->state == SLOT_READY )
+            {
+                strcpy( l_old_key, l_own->key );
+                l_old_len = l_own->len;
+            }
+            snprintf( l_own->key, sizeof( l_own->key ), "%s", t_key );
+            l_own->state = SLOT_BUSY;
+            l_own->owner = getpid();
+            l_own->len = 0;
+            l_own->last_use = ++g_cache->clock;
+            *t_own = true;
+        }
+        break;
+    }
+    cache_unlock();
+
+    // the slot is ours now, nobody else touches old image
+    if ( *l_old_key )
+        cache_spill( l_old_key, cache_data( l_slot ), l_old_len );
+
+    return l_slot;
+}
+
+// Owner is done with slot, t_len bytes of image are in it, or it stays empty
+// when t_len is 0. With t_read the image is pinned for reading by caller.
+void cache_finish( int t_slot, size_t t_len, bool t_read, unsigned long *t_counter )
+{
+    cache_lock();
+    cache_slot *l_slot = &g_cache->slots[ t_slot ];
+    l_slot->state = t_len ? SLOT_READY : SLOT_EMPTY;
+    l_slot->len = t_len;
+    l_slot->readers = 0;
+    memset( l_slot->reader_pids, 0, sizeof( l_slot->reader_pids ) );
+    if ( t_len && t_read ) cache_pin( l_slot );
+    l_slot->owner = 0;
+    ( *t_counter )++;
+    pthread_cond_broadcast( &g_cache->done );
+    cache_unlock();
+}
+
+void cache_unpin( int t_slot )
+{
+    cache_lock();
+    cache_slot *l_slot = &g_cache->slots[ t_slot ];
+    for ( int i = 0; i < CACHE_READERS; i++ )
+        if ( l_slot->reader_pids[ i ] == getpid() )
+        {
+            l_slot->reader_pids[ i ] = 0;
+            l_slot->readers--;
+            break;
+        }
+    cache_unlock();
+}
+
+// busy slots of terminated process would block waiting clients forever,
+// its pins would keep slots from reuse
+void cache_release( pid_t t_pid )
+{
+    if ( !g_cache ) return;
+
+    cache_lock();
+    for ( int i = 0; i < CACHE_SLOTS; i++ )
+    {
+        cache_slot *l_slot = &g_cache->slots[ i ];
+        if ( l_slot->state == SLOT_BUSY && l_slot->owner == t_pid )
+        {
+            log_msg( LOG_INFO, "Process %d left image %s unfinished.", t_pid, l_slot->key );
+            l_slot->state = SLOT_EMPTY;
+            l_slot->owner = 0;
+            pthread_cond_broadcast( &g_cache->done );
+        }
+
+        for ( int r = 0; r < CACHE_READERS; r++ )
+            if ( l_slot->reader_pids[ r ] == t_pid )
+            {
+                log_msg( LOG_INFO, "Process %d left image %s pinned.", t_pid, l_slot->key );
+                l_slot->reader_pids[ r ] = 0;
+                l_slot->readers--;
+                pthread_cond_broadcast( &g_cache->done );
+            }
+    }
+    cache_unlock();
+}
+
+void cache_log( const char *t_result, const char *t_key )
+{
+    cache_lock();
+    unsigned long l_hits = g_cache->hits;
+    unsigned long l_disk = g_cache->disk_hits;
+    unsigned long l_misses = g_cache->misses;
+    unsigned long l_coalesced = g_cache->coalesced;
+    cache_unlock();
+
+    log_msg( LOG_INFO, "Cache %s for %s (hits: %lu, disk: %lu, misses: %lu, coalesced: %lu).",
+             t_result, t_key, l_hits, l_disk, l_misses, l_coalesced );
+}
+
+//***************************************************************************
+// Convert image to requested resolution with pipeline convert | xz.
+// Compressed image is sent to client and stored into t_data (slot of cache),
+// image bigger than slot is stored into t_spill file. Without t_data image is
+// only sent, without client (-1) only stored. Returns length of image, or -1
+// when conversion failed.
+
+ssize_t convert_image( const char *t_resolution, int t_client_socket, char *t_data, const char *t_spill )
+{
+    // Create pipe for xz -> this process
+    int l_out_fd[ 2 ];
+    if ( pipe( l_out_fd ) < 0 )
+    {
+        log_msg( LOG_ERROR, "Pipe creation failed." );
+        return -1;
+    }
+
     // Create child process for image conversion with compression
     pid_t l_pid_convert = fork();
     if ( l_pid_convert < 0 )
     {
         log_msg( LOG_ERROR, "Fork failed for convert process." );
-        close( t_client_socket );
-        exit( 1 );
+        close( l_out_fd[ 0 ] );
+        close( l_out_fd[ 1 ] );
+        return -1;
     }
     
     if ( l_pid_convert == 0 )
     {
         // Child process for convert | xz pipeline
+        close( l_out_fd[ 0 ] );
+        close( t_client_socket );
         
         // Create pipe for convert -> xz
         int l_pipe_fd[ 2 ];
@@ -155,9 +603,9 @@ void handle_client( int t_client_socket )
             dup2( l_pipe_fd[ 0 ], STDIN_FILENO );
             close( l_pipe_fd[ 0 ] );
             
-            // Redirect stdout to socket
-            dup2( t_client_socket, STDOUT_FILENO );
-            close( t_client_socket );
+            // Redirect stdout to output pipe
+            dup2( l_out_fd[ 1 ], STDOUT_FILENO );
+            close( l_out_fd[ 1 ] );
             
             // Execute xz
             execlp( "xz", "xz", "-", "--stdout", nullptr );
@@ -168,26 +616,262 @@ void handle_client( int t_client_socket )
         {
             // Parent of xz - convert process
             close( l_pipe_fd[ 0 ] ); // Close read end
+            close( l_out_fd[ 1 ] );
             
             // Redirect stdout to pipe
             dup2( l_pipe_fd[ 1 ], STDOUT_FILENO );
             close( l_pipe_fd[ 1 ] );
-            close( t_client_socket );
             
             // Build convert command with resolution
             char l_resize_arg[ 257 ];
-            snprintf( l_resize_arg, sizeof( l_resize_arg ), "%s!", l_buf );
+            snprintf( l_resize_arg, sizeof( l_resize_arg ), "%s!", t_resolution );
             
             // Execute convert
-            execlp( "convert", "convert", "-resize", l_resize_arg, "podzim.png", "-", nullptr );
+            execlp( "convert", "convert", "-resize", l_resize_arg, IMAGE_FILE, "-", nullptr );
             log_msg( LOG_ERROR, "Exec convert failed." );
             exit( 1 );
         }
     }
-    
-    // Parent waits for conversion process to finish
+
+    close( l_out_fd[ 1 ] );
+
+    // Pass compressed image to client and cache
+    char l_tmp[ 600 ] = "";
+    int l_spill_fd = -1;
+    bool l_memory = t_data != nullptr;
+    bool l_client = t_client_socket >= 0;
+    bool l_ok = true;
+    size_t l_total = 0;
+    char l_buf[ 65536 ];
+
+    while ( 1 )
+    {
+        ssize_t l_len = read( l_out_fd[ 0 ], l_buf, sizeof( l_buf ) );
+        if ( l_len < 0 && errno == EINTR ) continue;
+        if ( l_len < 0 )
+        {
+            log_msg( LOG_ERROR, "Unable to read compressed image." );
+            l_ok = false;
+            break;
+        }
+        if ( l_len == 0 ) break;
+
+        // client may leave, conversion is finished for cache anyway
+        if ( l_client && !send_all( t_client_socket, l_buf, l_len ) )
+        {
+            log_msg( LOG_INFO, "Client left during transfer." );
+            l_client = false;
+        }
+
+        if ( l_memory && l_total + l_len > CACHE_SLOT_SIZE )
+        {
+            // too big for memory, whole image goes to spill file
+            l_memory = false;
+            snprintf( l_tmp, sizeof( l_tmp ), "%s.%d", t_spill, getpid() );
+            l_spill_fd = open( l_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+            if ( l_spill_fd < 0 || !write_all( l_spill_fd, t_data, l_total ) )
+            {
+                log_msg( LOG_ERROR, "Unable to create spill file '%s'.", l_tmp );
+                l_ok = false;
+            }
+        }
+
+        if ( l_spill_fd >= 0 )
+        {
+            if ( !write_all( l_spill_fd, l_buf, l_len ) )
+                l_ok = false;
+        }
+        else if ( l_memory )
+            memcpy( t_data + l_total, l_buf, l_len );
+
+        l_total += l_len;
+    }
+    close( l_out_fd[ 0 ] );
+
+    // Wait for conversion process to finish
     int l_status;
     waitpid( l_pid_convert, &l_status, 0 );
+    if ( !WIFEXITED( l_status ) || WEXITSTATUS( l_status ) )
+    {
+        log_msg( LOG_INFO, "Conversion to %s failed.", t_resolution );
+        l_ok = false;
+    }
+
+    if ( l_spill_fd >= 0 )
+    {
+        close( l_spill_fd );
+        if ( !l_ok || rename( l_tmp, t_spill ) < 0 )
+        {
+            unlink( l_tmp );
+            l_ok = false;
+        }
+        else
+            spill_trim();
+    }
+
+    return l_ok ? ( ssize_t ) l_total : -1;
+}
+
+// Image of spill file into cache slot, or its open file in *t_fd when it is
+// too big for slot (*t_fd is -1 otherwise). Returns length of image, 0 when
+// it is not in the cache directory or can not be read.
+ssize_t load_spill( const char *t_spill, char *t_data, int *t_fd )
+{
+    *t_fd = -1;
+    int l_fd = open( t_spill, O_RDONLY );
+    if ( l_fd < 0 ) return 0;
+
+    struct stat l_stat;
+    if ( fstat( l_fd, &l_stat ) < 0 || l_stat.st_size == 0 )
+    {
+        close( l_fd );
+        return 0;
+    }
+
+    // recently used for spill_trim
+    futimens( l_fd, nullptr );
+
+    // too big for memory, it is sent directly from file
+    if ( l_stat.st_size > CACHE_SLOT_SIZE )
+    {
+        *t_fd = l_fd;
+        return l_stat.st_size;
+    }
+
+    size_t l_total = 0;
+    while ( l_total < ( size_t ) l_stat.st_size )
+    {
+        ssize_t l_len = read( l_fd, t_data + l_total, l_stat.st_size - l_total );
+        if ( l_len < 0 && errno == EINTR ) continue;
+        if ( l_len <= 0 ) break;
+        l_total += l_len;
+    }
+    close( l_fd );
+
+    if ( l_total != ( size_t ) l_stat.st_size )
+    {
+        // damaged file, it will be converted again
+        log_msg( LOG_ERROR, "Unable to read spill file '%s'.", t_spill );
+        return 0;
+    }
+
+    return l_total;
+}
+
+// whole file to client, file is closed
+void send_file( int t_fd, int t_client_socket )
+{
+    char l_buf[ 65536 ];
+    while ( 1 )
+    {
+        ssize_t l_len = read( t_fd, l_buf, sizeof( l_buf ) );
+        if ( l_len < 0 && errno == EINTR ) continue;
+        if ( l_len < 0 ) log_msg( LOG_ERROR, "Unable to read image file." );
+        if ( l_len <= 0 ) break;
+
+        if ( !send_all( t_client_socket, l_buf, l_len ) )
+        {
+            log_msg( LOG_INFO, "Client left during transfer." );
+            break;
+        }
+    }
+    close( t_fd );
+}
+
+//***************************************************************************
+// Handle client communication in child process
+
+void handle_client( int t_client_socket )
+{
+    char l_buf[ 256 ];
+    
+    // Read resolution request from client
+    int l_len = read( t_client_socket, l_buf, sizeof( l_buf ) - 1 );
+    if ( l_len <= 0 )
+    {
+        log_msg( LOG_ERROR, "Unable to read resolution from client." );
+        close( t_client_socket );
+        exit( 1 );
+    }
+    
+    l_buf[ l_len ] = 0; // null terminate
+
+    // client that stops reading is dropped, it does not keep its process forever
+    timeval l_timeout = { SEND_TIMEOUT, 0 };
+    if ( setsockopt( t_client_socket, SOL_SOCKET, SO_SNDTIMEO, &l_timeout, sizeof( l_timeout ) ) < 0 )
+        log_msg( LOG_ERROR, "Unable to set send timeout." );
+    
+    // Remove newline if present
+    char *newline = strchr( l_buf, '\n' );
+    if ( newline ) *newline = 0;
+    
+    log_msg( LOG_INFO, "Client requested resolution: %s", l_buf );
+
+    // Cache key is normalized resolution "WxH" with mtime and size of source,
+    // changed source gets new keys
+    char l_resolution[ CACHE_KEY_LEN ];
+    char l_key[ CACHE_KEY_LEN ];
+    char l_stamp[ 48 ];
+    unsigned int l_width, l_height;
+    char l_rest;
+    int l_slot = -1;
+    bool l_own = false;
+
+    if ( g_cache && isdigit( l_buf[ 0 ] ) &&
+         sscanf( l_buf, "%ux%u%c", &l_width, &l_height, &l_rest ) == 2 &&
+         source_stamp( l_stamp, sizeof( l_stamp ) ) )
+    {
+        snprintf( l_resolution, sizeof( l_resolution ), "%ux%u", l_width, l_height );
+        snprintf( l_key, sizeof( l_key ), "%ux%u%s", l_width, l_height, l_stamp );
+        l_slot = cache_acquire( l_key, &l_own );
+    }
+
+    if ( l_slot < 0 )
+    {
+        // Not cacheable, or whole cache in use
+        convert_image( l_buf, t_client_socket, nullptr, nullptr );
+    }
+    else if ( !l_own )
+    {
+        // Image from memory
+        if ( !send_all( t_client_socket, cache_data( l_slot ), g_cache->slots[ l_slot ].len ) )
+            log_msg( LOG_INFO, "Client left during transfer." );
+        cache_unpin( l_slot );
+        cache_log( "hit", l_key );
+    }
+    else
+    {
+        char l_spill[ 512 ];
+        spill_path( l_key, l_spill, sizeof( l_spill ) );
+
+        // Image from cache directory, or its conversion. Slot is finished
+        // before client gets anything, waiting clients do not depend on it.
+        int l_file = -1;
+        const char *l_result = "disk hit";
+        unsigned long *l_counter = &g_cache->disk_hits;
+        ssize_t l_total = load_spill( l_spill, cache_data( l_slot ), &l_file );
+        if ( !l_total )
+        {
+            l_result = "miss";
+            l_counter = &g_cache->misses;
+            l_total = convert_image( l_resolution, -1, cache_data( l_slot ), l_spill );
+            // Bigger images stay in cache directory only
+            if ( l_total > CACHE_SLOT_SIZE && !load_spill( l_spill, nullptr, &l_file ) )
+                log_msg( LOG_ERROR, "Unable to open spill file '%s'.", l_spill );
+        }
+
+        bool l_memory = l_total > 0 && l_total <= CACHE_SLOT_SIZE;
+        cache_finish( l_slot, l_memory ? l_total : 0, l_memory, l_counter );
+        if ( l_memory )
+        {
+            if ( !send_all( t_client_socket, cache_data( l_slot ), l_total ) )
+                log_msg( LOG_INFO, "Client left during transfer." );
+            cache_unpin( l_slot );
+        }
+        else if ( l_file >= 0 )
+            send_file( l_file, t_client_socket );
+        cache_log( l_result, l_key );
+    }
     
     close( t_client_socket );
     log_msg( LOG_INFO, "Client connection closed." );
@@ -211,6 +895,12 @@ int main( int t_narg, char **t_args )
         if ( !strcmp( t_args[ i ], "-h" ) )
             help( t_narg, t_args );
 
+        if ( !strcmp( t_args[ i ], "-c" ) && i + 1 < t_narg )
+        {
+            g_cache_dir = t_args[ ++i ];
+            continue;
+        }
+
         if ( *t_args[ i ] != '-' && !l_port )
         {
             l_port = atoi( t_args[ i ] );
@@ -226,6 +916,8 @@ int main( int t_narg, char **t_args )
 
     log_msg( LOG_INFO, "Server will listen on port: %d.", l_port );
 
+    cache_create();
+
     // socket creation
     int l_sock_listen = socket( AF_INET, SOCK_STREAM, 0 );
     if ( l_sock_listen == -1 )
@@ -268,9 +960,11 @@ int main( int t_narg, char **t_args )
     {
         // Check for terminated child processes
         int l_status;
-        while ( waitpid( -1, &l_status, WNOHANG ) > 0 )
+        pid_t l_child;
+        while ( ( l_child = waitpid( -1, &l_status, WNOHANG ) ) > 0 )
         {
             log_msg( LOG_DEBUG, "Child process terminated." );
+            cache_release( l_child );
         }
 
         // list of fd sources
@@ -282,7 +976,8 @@ int main( int t_narg, char **t_args )
         l_read_poll[ 1 ].events = POLLIN;
 
         // select from fds
-        int l_poll = poll( l_read_poll, 2, -1 );
+        // with timeout, terminated children are found without new client
+        int l_poll = poll( l_read_poll, 2, 1000 );
 
         if ( l_poll < 0 )
         {
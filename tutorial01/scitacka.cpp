@@ -1,18 +1,377 @@
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// streaming summation of whitespace separated integers from stdin
+//
+// input is cut into chunks at whitespace; worker threads parse and sum the
+// chunks, the main thread merges the partial results in input order. like
+// the original scanf("%d") loop the input ends at the first token that is
+// not a number. a regular file on stdin is mapped instead of read
+
+#define CHUNK_SIZE (1024 * 1024) // bytes per chunk
+
+// partial result of one chunk
+struct partial {
+    __int128 sum;
+    long     count;
+    long     min;
+    long     max;
+    int      stop;  // chunk ended with a non-number
+};
+
+// ----------------------------------------------------------------------------
+// parser
+
+static inline int is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// 8 ASCII digits to their value (SWAR)
+static inline uint64_t parse_eight(const char* t_text) {
+    uint64_t l_val;
+    memcpy(&l_val, t_text, 8);
+    l_val -= 0x3030303030303030ULL;
+    l_val = (l_val * 10 + (l_val >> 8)) & 0x00ff00ff00ff00ffULL;
+    l_val = (l_val * 100 + (l_val >> 16)) & 0x0000ffff0000ffffULL;
+    l_val = (l_val * 10000 + (l_val >> 32)) & 0x00000000ffffffffULL;
+
+    return l_val;
+}
+
+// count of leading digits; at least 16 bytes readable at t_text
+static inline int leading_digits16(const char* t_text) {
+#if defined(__SSE2__)
+    __m128i l_bytes = _mm_loadu_si128((const __m128i*)t_text);
+    __m128i l_low = _mm_cmpgt_epi8(l_bytes, _mm_set1_epi8('0' - 1));
+    __m128i l_high = _mm_cmplt_epi8(l_bytes, _mm_set1_epi8('9' + 1));
+    unsigned l_mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(l_low, l_high));
+
+    return __builtin_ctz(~l_mask); // bit 16 of ~mask is always set
+#else
+    int l_len = 0;
+    while (l_len < 16 && t_text[l_len] >= '0' && t_text[l_len] <= '9')
+        l_len++;
+
+    return l_len;
+#endif
+}
+
+static void add_number(partial* t_part, long t_num) {
+    t_part->sum += t_num;
+    if (t_part->count == 0 || t_num < t_part->min)
+        t_part->min = t_num;
+    if (t_part->count == 0 || t_num > t_part->max)
+        t_part->max = t_num;
+    t_part->count++;
+}
+
+static void sum_chunk(const char* t_text, size_t t_len, partial* t_part) {
+    memset(t_part, 0, sizeof(*t_part));
+
+    const char* l_ptr = t_text;
+    const char* l_end = t_text + t_len;
+    while (1) {
+        while (l_ptr < l_end && is_space(*l_ptr))
+            l_ptr++;
+        if (l_ptr == l_end)
+            return;
+
+        int l_negative = 0;
+        if (*l_ptr == '-' || *l_ptr == '+') {
+            l_negative = *l_ptr == '-';
+            l_ptr++;
+        }
+
+        // number of digits; 16-byte SIMD scan where the chunk allows it
+        int l_digits = 0;
+        if (l_end - l_ptr >= 16)
+            l_digits = leading_digits16(l_ptr);
+        else
+            while (l_ptr + l_digits < l_end && l_ptr[l_digits] >= '0' && l_ptr[l_digits] <= '9')
+                l_digits++;
+
+        if (l_digits == 0) {
+            t_part->stop = 1; // not a number; the input ends here
+            return;
+        }
+
+        // 16 digits found may be the start of a longer number; those take the slow path
+        long l_num;
+        if (l_digits < 16 && l_end - l_ptr >= 16) {
+            // right-align into 16 '0' padded digits and parse as two SWAR halves
+            char l_buf[16];
+            memset(l_buf, '0', 16);
+            memcpy(l_buf + 16 - l_digits, l_ptr, l_digits);
+            l_num = (long)(parse_eight(l_buf) * 100000000ULL + parse_eight(l_buf + 8));
+            if (l_negative)
+                l_num = -l_num;
+        } else {
+            // long or near the end of the chunk; the whole digit run, leading
+            // zeros skipped, saturating at the long range like strtol
+            while (l_ptr + l_digits < l_end && l_ptr[l_digits] >= '0' && l_ptr[l_digits] <= '9')
+                l_digits++;
+
+            const char* l_digit = l_ptr;
+            const char* l_last = l_ptr + l_digits;
+            while (l_digit < l_last && *l_digit == '0')
+                l_digit++;
+
+            unsigned long l_limit = l_negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+            unsigned long l_abs = 0;
+            for (; l_digit < l_last; l_digit++) {
+                unsigned l_value = *l_digit - '0';
+                if (l_abs > (l_limit - l_value) / 10) {
+                    l_abs = l_limit;
+                    break;
+                }
+                l_abs = l_abs * 10 + l_value;
+            }
+            l_num = l_negative ? (long)(0UL - l_abs) : (long)l_abs;
+        }
+
+        add_number(t_part, l_num);
+        l_ptr += l_digits;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// worker pool
+
+struct chunk_slot {
+    const char* text;   // into the mapping or buf
+    size_t      len;
+    char*       buf;    // read mode buffer
+    partial     result;
+    int         state;  // 0 free, 1 queued, 2 done
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond_work;
+    pthread_cond_t  cond_done;
+    chunk_slot*     slots;
+    int             nslots;
+    long            next_work; // next queued chunk a worker takes
+    long            queued;    // chunks queued so far
+    int             quit;
+} g_pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, nullptr, 0, 0, 0, 0 };
+
+static void* worker_thread(void*) {
+    pthread_mutex_lock(&g_pool.lock);
+    while (1) {
+        while (!g_pool.quit && g_pool.next_work == g_pool.queued)
+            pthread_cond_wait(&g_pool.cond_work, &g_pool.lock);
+        if (g_pool.next_work == g_pool.queued)
+            break;
+
+        chunk_slot* l_slot = &g_pool.slots[g_pool.next_work++ % g_pool.nslots];
+        pthread_mutex_unlock(&g_pool.lock);
+
+        sum_chunk(l_slot->text, l_slot->len, &l_slot->result);
+
+        pthread_mutex_lock(&g_pool.lock);
+        l_slot->state = 2;
+        pthread_cond_broadcast(&g_pool.cond_done);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// input
+
+struct input {
+    const char* map;     // regular file mapped
+    size_t      map_len;
+    size_t      map_pos;
+    char        carry[CHUNK_SIZE]; // read mode: partial token of the previous read
+    size_t      carry_len;
+    int         eof;
+    int         error;   // read failed; what came before it is still summed
+};
+
+// next chunk ending at whitespace (or the input end); returns 0 at the end
+static int next_chunk(input* t_in, chunk_slot* t_slot) {
+    if (t_in->map) {
+        if (t_in->map_pos == t_in->map_len)
+            return 0;
+
+        size_t l_end = t_in->map_pos + CHUNK_SIZE;
+        if (l_end >= t_in->map_len)
+            l_end = t_in->map_len;
+        else
+            while (l_end < t_in->map_len && !is_space(t_in->map[l_end]))
+                l_end++;
+
+        t_slot->text = t_in->map + t_in->map_pos;
+        t_slot->len = l_end - t_in->map_pos;
+        t_in->map_pos = l_end;
+
+        return 1;
+    }
+
+    if (t_in->eof && t_in->carry_len == 0)
+        return 0;
+
+    if (!t_slot->buf)
+        t_slot->buf = (char*)malloc(2 * CHUNK_SIZE);
+
+    // the carried partial token first, then fill up to CHUNK_SIZE more
+    memcpy(t_slot->buf, t_in->carry, t_in->carry_len);
+    size_t l_len = t_in->carry_len;
+    while (!t_in->eof && l_len < t_in->carry_len + CHUNK_SIZE) {
+        ssize_t l_read = read(STDIN_FILENO, t_slot->buf + l_len, t_in->carry_len + CHUNK_SIZE - l_len);
+        if (l_read < 0 && errno == EINTR)
+            continue;
+        if (l_read < 0) {
+            fprintf(stderr, "chyba cteni: %s\n", strerror(errno));
+            t_in->error = 1;
+        }
+        if (l_read <= 0)
+            t_in->eof = 1;
+        else
+            l_len += l_read;
+    }
+
+    // cut after the last whitespace; the rest waits for the next read
+    size_t l_cut = l_len;
+    if (!t_in->eof) {
+        while (l_cut > 0 && !is_space(t_slot->buf[l_cut - 1]))
+            l_cut--;
+        if (l_cut == 0 || l_len - l_cut > CHUNK_SIZE)
+            l_cut = l_len; // one token longer than a chunk; not a valid number anyway
+    }
+
+    t_in->carry_len = l_len - l_cut;
+    memcpy(t_in->carry, t_slot->buf + l_cut, t_in->carry_len);
+
+    t_slot->text = t_slot->buf;
+    t_slot->len = l_cut;
+
+    return l_cut > 0 || t_in->carry_len > 0;
+}
+
+static void merge(partial* t_total, const partial* t_part) {
+    if (t_part->count) {
+        if (t_total->count == 0 || t_part->min < t_total->min)
+            t_total->min = t_part->min;
+        if (t_total->count == 0 || t_part->max > t_total->max)
+            t_total->max = t_part->max;
+    }
+    t_total->sum += t_part->sum;
+    t_total->count += t_part->count;
+    t_total->stop |= t_part->stop;
+}
+
+static void print_int128(__int128 t_value) {
+    char l_buf[48];
+    int  l_pos = sizeof(l_buf) - 1;
+    l_buf[l_pos] = 0;
+
+    unsigned __int128 l_abs = t_value < 0 ? -(unsigned __int128)t_value : (unsigned __int128)t_value;
+    do {
+        l_buf[--l_pos] = (char)('0' + (int)(l_abs % 10));
+        l_abs /= 10;
+    } while (l_abs);
+    if (t_value < 0)
+        l_buf[--l_pos] = '-';
+
+    fputs(l_buf + l_pos, stdout);
+}
 
 int main(int t_argc, char** t_argv) {
-    int sum = 0;
+    long l_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (t_argc == 3 && strcmp(t_argv[1], "-j") == 0)
+        l_threads = atoi(t_argv[2]);
+    else if (t_argc != 1) {
+        printf("pouziti: %s [-j vlakna] < cisla\n", t_argv[0]);
+        exit(1);
+    }
+    if (l_threads < 1)
+        l_threads = 1;
+
+    static input l_in;
+    struct stat l_stat;
+    if (fstat(STDIN_FILENO, &l_stat) == 0 && S_ISREG(l_stat.st_mode) && l_stat.st_size > 0) {
+        void* l_map = mmap(nullptr, l_stat.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (l_map != MAP_FAILED) {
+            madvise(l_map, l_stat.st_size, MADV_SEQUENTIAL);
+            l_in.map = (const char*)l_map;
+            l_in.map_len = l_stat.st_size;
+        }
+    }
+
+    g_pool.nslots = 2 * l_threads + 2;
+    g_pool.slots = (chunk_slot*)calloc(g_pool.nslots, sizeof(chunk_slot));
+    pthread_t* l_workers = (pthread_t*)calloc(l_threads, sizeof(pthread_t));
+    for (long i = 0; i < l_threads; i++)
+        pthread_create(&l_workers[i], nullptr, worker_thread, nullptr);
+
+    // read chunks into free slots; merge finished slots in input order
+    partial l_total;
+    memset(&l_total, 0, sizeof(l_total));
+    long l_merged = 0;
+    int  l_more = 1;
+
+    pthread_mutex_lock(&g_pool.lock);
+    while (!l_total.stop && (l_more || l_merged < g_pool.queued)) {
+        if (l_more && g_pool.queued - l_merged < g_pool.nslots) {
+            chunk_slot* l_slot = &g_pool.slots[g_pool.queued % g_pool.nslots];
+            pthread_mutex_unlock(&g_pool.lock);
+            l_more = next_chunk(&l_in, l_slot);
+            pthread_mutex_lock(&g_pool.lock);
+
+            if (l_more) {
+                l_slot->state = 1;
+                g_pool.queued++;
+                pthread_cond_signal(&g_pool.cond_work);
+            }
+            continue;
+        }
+
+        chunk_slot* l_slot = &g_pool.slots[l_merged % g_pool.nslots];
+        while (l_slot->state != 2)
+            pthread_cond_wait(&g_pool.cond_done, &g_pool.lock);
+
+        merge(&l_total, &l_slot->result);
+        l_slot->state = 0;
+        l_merged++;
+    }
 
-    while(1) {
-        int num;
+    // chunks behind a stop are still summed by the workers, but not merged
+    g_pool.quit = 1;
+    pthread_cond_broadcast(&g_pool.cond_work);
+    pthread_mutex_unlock(&g_pool.lock);
+    for (long i = 0; i < l_threads; i++)
+        pthread_join(l_workers[i], nullptr);
 
-        if (scanf("%d", &num) != 1) break;
-        sum += num;
+    printf("suma ");
+    print_int128(l_total.sum);
+    printf("\npocet %ld\n", l_total.count);
+    if (l_total.count) {
+        printf("min %ld\nmax %ld\n", l_total.min, l_total.max);
+        printf("prumer %.6Lf\n", (long double)l_total.sum / l_total.count);
     }
 
-    printf("suma %d\n", sum);
+    for (int i = 0; i < g_pool.nslots; i++)
+        free(g_pool.slots[i].buf);
+    free(g_pool.slots);
+    free(l_workers);
+    if (l_in.map)
+        munmap((void*)l_in.map, l_in.map_len);
 
+    return l_in.error ? 1 : 0;
 }
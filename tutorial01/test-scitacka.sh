@@ -0,0 +1,75 @@
+#!/bin/bash
+# script for testing scitacka against the original scanf loop
+
+cd "$(dirname "$0")"
+
+FAILED=0
+
+# reference: the original program; long and %ld for tokens beyond int
+echo "+++ [test] building reference"
+cat > scitacka_ref.cpp <<'EOF'
+#include <stdio.h>
+
+int main() {
+    long sum = 0;
+
+    while(1) {
+        long num;
+
+        if (scanf("%ld", &num) != 1) break;
+        sum += num;
+    }
+
+    printf("suma %ld\n", sum);
+}
+EOF
+g++ -O2 scitacka_ref.cpp -o scitacka_ref || exit 1
+
+# same 'suma' line as the reference, mapped and piped, one and more threads
+check() {
+    local l_expected=$(./scitacka_ref < scitacka_in.txt)
+    local l_result
+    for l_threads in 1 4; do
+        for l_mode in map pipe; do
+            if [ $l_mode == map ]; then
+                l_result=$(./scitacka -j $l_threads < scitacka_in.txt | head -1)
+            else
+                l_result=$(cat scitacka_in.txt | ./scitacka -j $l_threads | head -1)
+            fi
+            if [ "$l_result" == "$l_expected" ]; then
+                echo "+++ [test] PASS: $1 ($l_mode, -j $l_threads)"
+            else
+                echo "+++ [test] FAIL: $1 ($l_mode, -j $l_threads)"
+                echo "    expected: '$l_expected'"
+                echo "    got:      '$l_result'"
+                FAILED=1
+            fi
+        done
+    done
+}
+
+echo "+++ [test] zero padded tokens longer than 16 and 32 digits"
+printf '00000000000000000000000000000012 5\n-0000000000000000000000000000000000000007\n+0000000000000000003\n' > scitacka_in.txt
+check "long zero padded tokens"
+
+echo "+++ [test] tokens out of the long range"
+printf '99999999999999999999999 -5\n' > scitacka_in.txt
+check "saturation at LONG_MAX"
+printf -- '-000000000000000000000000099999999999999999999999 7\n' > scitacka_in.txt
+check "saturation at LONG_MIN"
+
+echo "+++ [test] padded tokens across chunk borders"
+awk 'BEGIN { srand(1); for (i = 0; i < 400000; i++) {
+        z = ""; for (n = int(rand() * 40); n > 0; n--) z = z "0";
+        printf "%s%s%d%s", (rand() < 0.3 ? "-" : ""), z, int(rand() * 100000), (i % 7 ? " " : "\n") } }' > scitacka_in.txt
+check "mixed padded tokens"
+
+echo "+++ [test] input ending at a non-number"
+printf '0000000000000000000000000000001 2 x 100\n' > scitacka_in.txt
+check "stop at a non-number"
+
+echo "+++ [test] cleaning up"
+rm -f scitacka_ref scitacka_ref.cpp scitacka_in.txt
+
+echo "+++ [test] done"
+exit $FAILED